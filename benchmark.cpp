@@ -0,0 +1,319 @@
+/*
+    Benchmark harness for the planarity testers. Every backend binary is
+    run with --stats over the graphs of a corpus directory and over random
+    maximal planar graphs of increasing size, a few untimed warmup runs
+    first and then the measured trials. One JSON object per backend and
+    graph is printed with the median and 95th percentile wall time of the
+    whole run and of each phase, the allocations of each phase and the
+    peak resident set size.
+
+    Build the testers, with allocation counting (see includes/stats.hpp),
+    and the harness with
+
+        g++ -O2 -std=c++11 -pthread -DCOUNT_ALLOCS planarity_test.cpp -o planarity_test
+        g++ -O2 -std=c++11 -pthread -DCOUNT_ALLOCS planarity_test_hash.cpp -o planarity_test_hash
+        g++ -O2 -std=c++11 -pthread -DCOUNT_ALLOCS planarity_test_avl.cpp -o planarity_test_avl
+        g++ -O2 -std=c++11 -pthread benchmark.cpp -o benchmark
+
+    Usage: benchmark [-w warmup] [-n trials] [-c corpus] [-s sizes] [backend ...]
+
+    -w and -n default to 1 and 5, -c to inputs/ and -s to
+    1000,2000,4000,8000 (0 skips the generated graphs). The backends
+    default to ./planarity_test, ./planarity_test_hash and
+    ./planarity_test_avl. The corpus includes the graphs in its
+    subdirectories, named by their path from it.
+*/
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#define pb push_back
+#define mp make_pair
+
+using namespace std;
+
+#include "includes/helpers.hpp"
+#include "includes/graph_io.hpp"
+#include "includes/mmap_reader.hpp"
+
+/*
+    Sample holds the numbers of one run of a backend on one graph.
+
+    names  -> phases in the order the backend reported them, each one
+              with its seconds, allocations, bytes and peak rss
+    answer -> YES or NO, empty if the backend did not finish
+*/
+struct Sample {
+    double wall;
+    long peak;
+    vector<string> names;
+    map<string, double> seconds;
+    map<string, long> allocs, bytes, rss;
+    string answer;
+};
+
+/*
+    generatePlanar writes a random maximal planar graph with n >= 3 vertices to
+    path as an edge list. Every vertex is stacked into a random face of
+    the triangulation so far, then the vertices are relabelled at random
+    so that the low degree vertices are not all at the end.
+*/
+bool generatePlanar(int n, unsigned seed, const string& path)
+{
+    mt19937 rng(seed);
+    vector<int> label(n);
+    for (int i = 0; i < n; i++)
+        label[i] = i;
+    shuffle(label.begin(), label.end(), rng);
+
+    vector<pair<int, int> > edges;
+    vector<int> faces;
+    edges.pb(mp(0, 1)); edges.pb(mp(1, 2)); edges.pb(mp(0, 2));
+    int outer[] = {0, 1, 2, 0, 2, 1};
+    faces.insert(faces.end(), outer, outer + 6);
+    for (int v = 3; v < n; v++) {
+        int f = uniform_int_distribution<int>(0, faces.size() / 3 - 1)(rng);
+        int a = faces[3 * f], b = faces[3 * f + 1], c = faces[3 * f + 2];
+        edges.pb(mp(a, v)); edges.pb(mp(b, v)); edges.pb(mp(c, v));
+        faces[3 * f + 2] = v;
+        int split[] = {b, c, v, c, a, v};
+        faces.insert(faces.end(), split, split + 6);
+    }
+
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out)
+        return false;
+    fprintf(out, "%d %d\n", n, (int)edges.size());
+    for (int i = 0; i < edges.size(); i++) {
+        int u = label[edges[i].first], v = label[edges[i].second];
+        fprintf(out, "%d %d\n", min(u, v), max(u, v));
+    }
+    fclose(out);
+    return true;
+}
+
+/*
+    runOnce runs backend with --stats on the graph in path and parses the
+    stats lines it writes to stderr. Returns false if it could not run.
+*/
+bool runOnce(const string& backend, const string& path, Sample& s)
+{
+    int in = open(path.c_str(), O_RDONLY);
+    if (in == -1)
+        return false;
+    int err[2];
+    if (pipe(err) == -1) {
+        ::close(in);
+        return false;
+    }
+
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(in, 0);
+        dup2(null, 1);
+        dup2(err[1], 2);
+        ::close(err[0]);
+        execl(backend.c_str(), backend.c_str(), "--stats", (char*)NULL);
+        _exit(127);
+    }
+    ::close(in);
+    ::close(err[1]);
+    if (pid == -1) {
+        ::close(err[0]);
+        return false;
+    }
+
+    string text;
+    char buf[4096];
+    ssize_t got;
+    while ((got = read(err[0], buf, sizeof(buf))) > 0)
+        text.append(buf, got);
+    ::close(err[0]);
+
+    int status;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    s.wall = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    s.peak = usage.ru_maxrss;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) == 127)
+        return false;
+
+    size_t at = 0;
+    while (at < text.size()) {
+        size_t end = text.find('\n', at);
+        if (end == string::npos)
+            end = text.size();
+        string line = text.substr(at, end - at);
+        at = end + 1;
+
+        char name[64], answer[8];
+        double sec;
+        long allocs, bytes, rss;
+        if (sscanf(line.c_str(), "stats answer %7s", answer) == 1)
+            s.answer = answer;
+        else if (sscanf(line.c_str(), "stats %63s %lf %ld %ld %ld", name, &sec, &allocs, &bytes, &rss) == 5) {
+            s.names.pb(name);
+            s.seconds[name] = sec;
+            s.allocs[name] = allocs;
+            s.bytes[name] = bytes;
+            s.rss[name] = rss;
+        }
+    }
+    return true;
+}
+
+/*
+    percentile returns the p-th percentile of xs, nearest rank.
+*/
+double percentile(vector<double> xs, double p)
+{
+    sort(xs.begin(), xs.end());
+    int k = (int)(p * xs.size() + 0.999999) - 1;
+    return xs[max(0, min(k, (int)xs.size() - 1))];
+}
+
+/*
+    printTimes prints "median" and "p95" of xs as JSON members.
+*/
+void printTimes(const vector<double>& xs)
+{
+    printf("\"median\": %.9f, \"p95\": %.9f", percentile(xs, 0.5), percentile(xs, 0.95));
+}
+
+/*
+    bench runs backend on the graph in path and prints its JSON object.
+*/
+void bench(const string& backend, const string& graph, const string& path, int warmup, int trials, bool& first)
+{
+    Sample s;
+    for (int i = 0; i < warmup; i++)
+        runOnce(backend, path, s);
+
+    vector<Sample> samples;
+    for (int i = 0; i < trials; i++) {
+        Sample t;
+        if (runOnce(backend, path, t) && !t.answer.empty())
+            samples.pb(t);
+    }
+
+    printf("%s\n  {\"backend\": \"%s\", \"graph\": \"%s\", \"trials\": %d",
+        first ? "" : ",", backend.c_str(), graph.c_str(), (int)samples.size());
+    first = false;
+    if (samples.empty()) {
+        printf(", \"error\": \"no successful run\"}");
+        return;
+    }
+
+    vector<double> wall;
+    long rss = 0;
+    for (int i = 0; i < samples.size(); i++) {
+        wall.pb(samples[i].wall);
+        rss = max(rss, samples[i].peak);
+    }
+    printf(", \"answer\": \"%s\", \"peak_rss_kb\": %ld, \"wall\": {", samples[0].answer.c_str(), rss);
+    printTimes(wall);
+    printf("}, \"phases\": {");
+
+    const vector<string>& names = samples[0].names;
+    for (int k = 0; k < names.size(); k++) {
+        vector<double> sec;
+        long peak = 0;
+        for (int i = 0; i < samples.size(); i++) {
+            sec.pb(samples[i].seconds[names[k]]);
+            peak = max(peak, samples[i].rss[names[k]]);
+        }
+        printf("%s\"%s\": {", k ? ", " : "", names[k].c_str());
+        printTimes(sec);
+        printf(", \"allocs\": %ld, \"bytes\": %ld, \"peak_rss_kb\": %ld}",
+            samples[0].allocs[names[k]], samples[0].bytes[names[k]], peak);
+    }
+    printf("}}");
+    fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+    int warmup = 1, trials = 5;
+    string corpus = "inputs";
+    vector<int> sizes;
+    int defaults[] = {1000, 2000, 4000, 8000};
+    sizes.assign(defaults, defaults + 4);
+    vector<string> backends;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool more = i + 1 < argc;
+        if (arg == "-w" && more)
+            warmup = atoi(argv[++i]);
+        else if (arg == "-n" && more)
+            trials = max(1, atoi(argv[++i]));
+        else if (arg == "-c" && more)
+            corpus = argv[++i];
+        else if (arg == "-s" && more) {
+            sizes.clear();
+            for (char* p = strtok(argv[++i], ","); p; p = strtok(NULL, ","))
+                if (atoi(p) >= 3)
+                    sizes.pb(atoi(p));
+        } else
+            backends.pb(arg);
+    }
+    if (backends.empty()) {
+        backends.pb("./planarity_test");
+        backends.pb("./planarity_test_hash");
+        backends.pb("./planarity_test_avl");
+    }
+
+    // graphs -> (name, path) of every input, the corpus first
+    vector<pair<string, string> > graphs;
+    vector<string> files;
+    if (!corpus.empty() && listFiles(corpus.c_str(), files, true))
+        for (int i = 0; i < files.size(); i++)
+            graphs.pb(mp(files[i], corpus + "/" + files[i]));
+
+    char dir[] = "/tmp/benchmarkXXXXXX";
+    if (!sizes.empty() && !mkdtemp(dir)) {
+        fprintf(stderr, "cannot create a temporary directory\n");
+        return 1;
+    }
+    vector<string> generated;
+    for (int i = 0; i < sizes.size(); i++) {
+        char name[64];
+        sprintf(name, "planar-%d", sizes[i]);
+        string path = string(dir) + "/" + name;
+        if (!generatePlanar(sizes[i], sizes[i], path)) {
+            fprintf(stderr, "cannot write %s\n", path.c_str());
+            continue;
+        }
+        generated.pb(path);
+        graphs.pb(mp(string(name), path));
+    }
+
+    bool first = true;
+    printf("[");
+    for (int g = 0; g < graphs.size(); g++)
+        for (int b = 0; b < backends.size(); b++)
+            bench(backends[b], graphs[g].first, graphs[g].second, warmup, trials, first);
+    printf("\n]\n");
+
+    for (int i = 0; i < generated.size(); i++)
+        unlink(generated[i].c_str());
+    if (!sizes.empty())
+        rmdir(dir);
+    return 0;
+}
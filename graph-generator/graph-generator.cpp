@@ -1,20 +1,57 @@
+#include <algorithm>
 #include <iostream>
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define pb push_back
+#define mp make_pair
 
 using namespace std;
 
-int main(){
+#include "../includes/graph_writer.hpp"
+
+/*
+    Usage: graph-generator [--out dense|edges|binary]
+
+    Reads n and writes a complete graph on n vertices with random
+    weights in [0, 200), as a dense matrix unless --out says otherwise
+    (see includes/graph_writer.hpp).
+*/
+int main(int argc, char** argv){
     ios::sync_with_stdio(false);
     int n;
     cin >> n;
     srand(time(NULL));
-    cout << n << endl;
+    OutputFormat format = parseOutputFormat(argc, argv);
+    Writer out(1);
+
+    // the matrix is written as it is drawn, the other formats
+    // need the whole edge list
+    if (format == OUTPUT_DENSE) {
+        out.putInt(n);
+        out.putChar('\n');
+        for ( int i = 0; i < n; i++ ){
+            for ( int j = i+1; j < n; j++ ){
+                out.putInt(rand() % 200);
+                out.putChar(' ');
+            }
+            out.putChar('\n');
+        }
+        return 0;
+    }
+
+    vector<pair<int, int> > edges;
+    vector<int> weights;
     for ( int i = 0; i < n; i++ ){
         for ( int j = i+1; j < n; j++ ){
-            cout << rand() % 200 << " ";
+            edges.pb(mp(i, j));
+            weights.pb(rand() % 200);
         }
-        cout << endl;
     }
+    writeGraph(out, format, n, edges, weights);
     return 0;
-}
\ No newline at end of file
+}
@@ -1,31 +1,75 @@
+#ifndef AVL_HPP
+#define AVL_HPP
+
 struct node {
     int key;
     unsigned char height;
     node* left;
     node* right;
+    node() {
+        key = 0; left = right = 0; height = 1;
+    }
     node(int k) {
         key = k; left = right = 0; height = 1;
     }
 };
 
-unsigned char height(node* p)
+/*
+    NodePool hands out nodes from blocks it owns. Nodes are never freed
+    one by one: reset() recycles all of them at once in O(1), and the
+    blocks are kept for the next trees until the pool is destroyed.
+*/
+struct NodePool {
+    static const int BLOCK = 4096;
+    vector<node*> blocks;
+    // used -> number of nodes handed out since the last reset
+    int used;
+
+    NodePool() {
+        used = 0;
+    }
+
+    ~NodePool() {
+        for (int i = 0; i < blocks.size(); i++)
+            delete[] blocks[i];
+    }
+
+    node* make(int k) {
+        if (used == blocks.size() * BLOCK)
+            blocks.push_back(new node[BLOCK]);
+        node* p = &blocks[used / BLOCK][used % BLOCK];
+        used++;
+        p->key = k; p->left = p->right = 0; p->height = 1;
+        return p;
+    }
+
+    void reset() {
+        used = 0;
+    }
+
+private:
+    NodePool(const NodePool&);
+    NodePool& operator=(const NodePool&);
+};
+
+inline unsigned char height(node* p)
 {
     return p ? p->height : 0;
 }
 
-int b_factor(node* p)
+inline int b_factor(node* p)
 {
     return height(p->right) - height(p->left);
 }
 
-void fix_height(node* p)
+inline void fix_height(node* p)
 {
     unsigned char hl = height(p->left);
     unsigned char hr = height(p->right);
     p->height = ((hl > hr) ? hl : hr) + 1;
 }
 
-node* rotate_right(node* p)
+inline node* rotate_right(node* p)
 {
     node* q = p->left;
     p->left = q->right;
@@ -35,7 +79,7 @@ node* rotate_right(node* p)
     return q;
 }
 
-node* rotate_left(node* q)
+inline node* rotate_left(node* q)
 {
     node* p = q->right;
     q->right = p->left;
@@ -46,7 +90,7 @@ node* rotate_left(node* q)
 }
 
 // balance balances a p node.
-node* balance(node* p)
+inline node* balance(node* p)
 {
     fix_height(p);
     if (b_factor(p) == 2) {
@@ -63,27 +107,29 @@ node* balance(node* p)
     return p;
 }
 
-// insert inserts k key in a tree with p root.
-node* insert(node* p, int k)
+// insert inserts k key in a tree with p root, taking the new node from pool.
+inline node* insert(NodePool& pool, node* p, int k)
 {
-    if (!p) return new node(k);
+    if (!p) return pool.make(k);
     if (k < p->key)
-        p->left = insert(p->left, k);
+        p->left = insert(pool, p->left, k);
     else
-        p->right = insert(p->right, k);
+        p->right = insert(pool, p->right, k);
     return balance(p);
 }
 
 // find_min finds a node with minimal key in a p tree.
-node* find_min(node* p)
+inline node* find_min(node* p)
 {
     return p->left ? find_min(p->left) : p;
 }
 
-bool find(node *p, int key)
+inline bool find(node *p, int key)
 {
     if (!p) return false;
     if (key == p->key) return true;
     if (key < p->key) return find(p->left, key);
     else return find(p->right, key);
-}
\ No newline at end of file
+}
+
+#endif
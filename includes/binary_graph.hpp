@@ -0,0 +1,113 @@
+/*
+    The binary graph format passes graphs between the generator, tmfg and
+    the testers without printing and parsing text. A file (or stream)
+    holds one or more graphs, each laid out as
+
+        BinaryHeader                 32 bytes, see below
+        offset[0], ..., offset[V]    int32, CSR offsets, offset[V] == 2E
+        adj[0], ..., adj[2E - 1]     int32, sorted neighbours of each vertex
+        weight[0], ..., weight[2E-1] int32, only with BINARY_WEIGHTED,
+                                     weight[i] belongs to the edge of adj[i]
+
+    in the byte order of the machine, i.e. little-endian on every host
+    this code runs on. This is exactly the form of Graph (see
+    includes/csr_graph.hpp), so a mapped file is used in place: every
+    array stays 4-byte aligned, also for the graphs following the first.
+
+    The magic starts with a byte that never begins a text graph, so the
+    readers tell the formats apart by the first byte.
+*/
+#ifndef BINARY_GRAPH_HPP
+#define BINARY_GRAPH_HPP
+
+#include <cstring>
+
+#include "csr_graph.hpp"
+
+const char BINARY_MAGIC[4] = {'\x89', 'C', 'S', 'R'};
+const unsigned BINARY_VERSION = 1;
+// flags
+const unsigned BINARY_WEIGHTED = 1;
+
+struct BinaryHeader {
+    char magic[4];
+    unsigned version, flags;
+    int V, E;
+    unsigned reserved[3];
+};
+
+/*
+    isBinaryGraph checks if the n bytes at p start a binary graph.
+*/
+inline bool isBinaryGraph(const char* p, size_t n)
+{
+    return n >= 1 && p[0] == BINARY_MAGIC[0];
+}
+
+/*
+    binarySize returns the bytes taken by the graph of the given header,
+    header included.
+*/
+inline size_t binarySize(const BinaryHeader& h)
+{
+    size_t slots = (size_t)(h.V + 1) + 2 * (size_t)h.E;
+    if (h.flags & BINARY_WEIGHTED)
+        slots += 2 * (size_t)h.E;
+    return sizeof(BinaryHeader) + slots * sizeof(int);
+}
+
+/*
+    viewBinaryGraph points graph at the binary graph in the n bytes at p,
+    and weights at its weights, or NULL if it has none. Nothing is copied,
+    so the bytes must outlive graph. Returns the bytes taken by the graph,
+    or 0 if they do not hold a valid one.
+*/
+inline size_t viewBinaryGraph(const char* p, size_t n, Graph& graph, const int*& weights)
+{
+    BinaryHeader h;
+    if (n < sizeof(h))
+        return 0;
+    memcpy(&h, p, sizeof(h));
+    if (memcmp(h.magic, BINARY_MAGIC, 4) || h.version != BINARY_VERSION
+        || h.V < 0 || h.E < 0 || binarySize(h) > n)
+        return 0;
+
+    const int* offset = (const int*)(p + sizeof(h));
+    const int* adj = offset + h.V + 1;
+    // the arrays are trusted to be sorted, but never to send a reader
+    // out of bounds
+    if (offset[0] != 0 || offset[h.V] != 2 * h.E)
+        return 0;
+    for (int v = 0; v < h.V; v++)
+        if (offset[v] > offset[v + 1])
+            return 0;
+    for (int i = 0; i < 2 * h.E; i++)
+        if ((unsigned)adj[i] >= (unsigned)h.V)
+            return 0;
+
+    graph.view(h.V, h.E, offset, adj);
+    weights = (h.flags & BINARY_WEIGHTED ? adj + 2 * h.E : NULL);
+    return binarySize(h);
+}
+
+/*
+    binaryEdges lists the edges (u, v), u < v, of a viewed binary graph
+    and their weights, 1 when it has none, as readGraph does.
+*/
+inline void binaryEdges(const Graph& graph, const int* weights,
+    vector<pair<int, int> >& edges, vector<int>& edgeWeights)
+{
+    edges.clear();
+    edgeWeights.clear();
+    edges.reserve(graph.E);
+    edgeWeights.reserve(graph.E);
+    for (int u = 0; u < graph.V; u++)
+        for (int i = graph.offset[u]; i < graph.offset[u + 1]; i++) {
+            if (graph.adj[i] <= u)
+                continue;
+            edges.push_back(make_pair(u, graph.adj[i]));
+            edgeWeights.push_back(weights ? weights[i] : 1);
+        }
+}
+
+#endif
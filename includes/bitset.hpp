@@ -0,0 +1,53 @@
+/*
+    Bitset stores a set of integers in [0, n) as one bit per value,
+    packed into 64-bit words: value v lives in bit v % 64 of word v / 64.
+
+    It remembers the words written since the last clear, so clear() costs
+    O(values inserted) instead of O(n / 64).
+*/
+#ifndef BITSET_HPP
+#define BITSET_HPP
+
+struct Bitset {
+    vector<unsigned long long> words;
+    // touched -> words which may be non-zero
+    vector<int> touched;
+
+    /*
+        resize makes room for the values [0, n) and empties the set.
+    */
+    void resize(int n)
+    {
+        words.assign((n + 63) >> 6, 0);
+        touched.clear();
+    }
+
+    bool find(int val) const
+    {
+        return (words[val >> 6] >> (val & 63)) & 1;
+    }
+
+    void insert(int val)
+    {
+        unsigned long long& w = words[val >> 6];
+        if (!w)
+            touched.push_back(val >> 6);
+        w |= 1ULL << (val & 63);
+    }
+
+    /*
+        clear empties the set, falling back to a full sweep when most of
+        the words were touched anyway.
+    */
+    void clear()
+    {
+        if (touched.size() * 4 > words.size())
+            fill(words.begin(), words.end(), 0);
+        else
+            for (int i = 0; i < touched.size(); i++)
+                words[touched[i]] = 0;
+        touched.clear();
+    }
+};
+
+#endif
@@ -0,0 +1,95 @@
+/*
+    Graph stores an undirected graph in compressed sparse row form.
+    The neighbours of v are adj[offset[v]], ..., adj[offset[v + 1] - 1],
+    sorted in increasing order.
+
+    offset and adj point either into the graph's own arrays, filled by
+    build(), or into memory owned by someone else, such as a mapped
+    binary graph (see includes/binary_graph.hpp), set by view().
+*/
+#ifndef CSR_GRAPH_HPP
+#define CSR_GRAPH_HPP
+
+#include "instrument.hpp"
+
+struct Graph {
+    int V, E;
+    const int* offset;
+    const int* adj;
+
+    Graph()
+    {
+        V = E = 0;
+        offset = adj = NULL;
+    }
+
+    Graph(const Graph& g)
+    {
+        *this = g;
+    }
+
+    Graph& operator=(const Graph& g)
+    {
+        V = g.V;
+        E = g.E;
+        ownOffset = g.ownOffset;
+        ownAdj = g.ownAdj;
+        bool owned = (g.offset == g.ownOffset.data());
+        offset = (owned ? ownOffset.data() : g.offset);
+        adj = (owned ? ownAdj.data() : g.adj);
+        return *this;
+    }
+
+    int degree(int v) const
+    {
+        return offset[v + 1] - offset[v];
+    }
+
+    /*
+        build fills the graph with n vertices and the given edges,
+        which must not contain loops or duplicates.
+    */
+    void build(int n, const vector<pair<int, int> >& edges)
+    {
+        V = n;
+        E = edges.size();
+        ownOffset.assign(V + 1, 0);
+        for (int i = 0; i < E; i++) {
+            ownOffset[edges[i].first + 1]++;
+            ownOffset[edges[i].second + 1]++;
+        }
+        for (int v = 0; v < V; v++)
+            ownOffset[v + 1] += ownOffset[v];
+
+        // at -> next free slot of each vertex
+        vector<int> at(ownOffset.begin(), ownOffset.end() - 1);
+        ownAdj.resize(2 * E);
+        for (int i = 0; i < E; i++) {
+            ownAdj[at[edges[i].first]++] = edges[i].second;
+            ownAdj[at[edges[i].second]++] = edges[i].first;
+        }
+        Probe probe(PROBE_SORT);
+        for (int v = 0; v < V; v++)
+            sort(ownAdj.begin() + ownOffset[v], ownAdj.begin() + ownOffset[v + 1]);
+        offset = ownOffset.data();
+        adj = ownAdj.data();
+    }
+
+    /*
+        view makes the graph use the given arrays, which must already be
+        in the form described above and outlive the graph's use of them.
+    */
+    void view(int n, int m, const int* offsets, const int* neighbours)
+    {
+        V = n;
+        E = m;
+        offset = offsets;
+        adj = neighbours;
+    }
+
+private:
+    // the arrays filled by build()
+    vector<int> ownOffset, ownAdj;
+};
+
+#endif
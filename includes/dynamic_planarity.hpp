@@ -0,0 +1,308 @@
+/*
+    DynamicPlanarity keeps a graph together with a planar embedding of it
+    and answers, after every batch of edge updates, whether the graph is
+    still maximal planar, without testing it again from scratch whenever
+    the embedding can be repaired where it changed:
+
+    - a flip replaces the edge shared by two triangles (a, b, c) and
+      (b, a, d) by (c, d), which is only refused when (c, d) is an edge
+      already: one lookup. The triangles are read off the embedding, so
+      a flip that comes after the repairs ended embeds the graph again
+      first.
+    - a delete merges the two faces of the edge into one.
+    - an insert becomes a chord of a face holding both ends, found by
+      walking the faces around one end that are not triangles.
+
+    As long as every update is repaired like this the embedding stays
+    planar, and the graph is maximal planar exactly when it has 3V - 6
+    edges. An insert whose ends share no face ends the repairs: once the
+    batch is applied the graph goes through the full recognition, order()
+    and embed() of includes/planarity.hpp, or the left-right test of
+    includes/lr_planarity.hpp when its edge count already rules the
+    first one out, and the embedding either of them finds is kept.
+
+        DynamicPlanarity dynamic;
+        bool yes = dynamic.reset(graph);
+        yes = dynamic.apply(batch);
+*/
+#ifndef DYNAMIC_PLANARITY_HPP
+#define DYNAMIC_PLANARITY_HPP
+
+#include <unordered_map>
+
+#include "lr_planarity.hpp"
+#include "planarity.hpp"
+
+enum UpdateKind {UPDATE_FLIP, UPDATE_INSERT, UPDATE_DELETE};
+
+/*
+    Update is one change of a batch, on the edge (u, v):
+
+    UPDATE_FLIP   -> replaces (u, v) by the edge joining the two vertices
+                     across it, which needs both faces of (u, v) to be
+                     triangles of the embedding
+    UPDATE_INSERT -> adds (u, v)
+    UPDATE_DELETE -> removes (u, v)
+*/
+struct Update {
+    UpdateKind kind;
+    int u, v;
+};
+
+class DynamicPlanarity {
+public:
+    /*
+        threads is passed on to the PlanarityTester of the full
+        recognitions.
+    */
+    DynamicPlanarity(int threads = 1) : tester(threads)
+    {
+        V = stamp = rechecks = 0;
+        embedded = maximal = false;
+    }
+
+    /*
+        reset starts over from g, which is tested in full. Returns
+        whether it is maximal planar.
+    */
+    bool reset(const Graph& g)
+    {
+        V = g.V;
+        edges.clear();
+        edges.reserve(g.E);
+        for (int u = 0; u < V; u++)
+            for (int i = g.offset[u]; i < g.offset[u + 1]; i++)
+                if (g.adj[i] > u)
+                    edges[key(u, g.adj[i])] = -1;
+        return recheck();
+    }
+
+    /*
+        apply makes the updates of batch in order and returns whether the
+        graph is maximal planar afterwards. Updates that do not fit the
+        graph are left out, and counted in refused when it is not NULL:
+        loops, inserts of edges already there, deletes and flips of
+        missing ones, and flips that are not allowed (see Update) or
+        come while the graph is not planar.
+    */
+    bool apply(const vector<Update>& batch, int* refused = NULL)
+    {
+        int skipped = 0;
+        for (int i = 0; i < batch.size(); i++)
+            if (!update(batch[i]))
+                skipped++;
+        if (refused)
+            *refused = skipped;
+        if (!embedded)
+            return recheck();
+        maximal = (V >= 4 && edges.size() == 3 * V - 6);
+        return maximal;
+    }
+
+    bool isMaximalPlanar() const
+    {
+        return maximal;
+    }
+
+    /*
+        edgeList stores the edges (u, v), u < v, of the graph in
+        increasing order.
+    */
+    void edgeList(vector<pair<int, int> >& list) const
+    {
+        list.clear();
+        list.reserve(edges.size());
+        for (unordered_map<long long, int>::const_iterator it = edges.begin(); it != edges.end(); ++it)
+            list.push_back(make_pair((int)(it->first / V), (int)(it->first % V)));
+        sort(list.begin(), list.end());
+    }
+
+    // rechecks -> full recognitions run so far, reset() included
+    int rechecks;
+
+private:
+    /*
+        edges    -> every edge, by key(), with its half-edge from the
+                    smaller end while embedded
+        embedded -> whether rotation is a planar embedding of the graph
+        maximal  -> the answer for the graph as it is
+        spare    -> erased edges of rotation, to be reused
+        seen     -> stamp of the half-edges walked by the current insert
+    */
+    int V;
+    bool embedded, maximal;
+    unordered_map<long long, int> edges;
+    RotationSystem rotation;
+    vector<int> spare, seen;
+    int stamp;
+    PlanarityTester tester;
+    LrPlanarity lr;
+    Graph graph;
+
+    long long key(int u, int v) const
+    {
+        return (long long)min(u, v) * V + max(u, v);
+    }
+
+    /*
+        update makes one update, repairing the embedding if there is one.
+        Returns false if it was refused.
+    */
+    bool update(const Update& up)
+    {
+        int u = up.u, v = up.v;
+        if (u == v || (unsigned)u >= (unsigned)V || (unsigned)v >= (unsigned)V)
+            return false;
+        unordered_map<long long, int>::iterator it = edges.find(key(u, v));
+        if (up.kind == UPDATE_FLIP) {
+            if (it == edges.end())
+                return false;
+            if (!embedded)
+                recheck();
+            return embedded && flip(edges[key(u, v)]);
+        }
+        if (up.kind == UPDATE_DELETE) {
+            if (it == edges.end())
+                return false;
+            if (embedded)
+                drop(it->second);
+            edges.erase(it);
+            return true;
+        }
+        if (it != edges.end())
+            return false;
+        edges[key(u, v)] = -1;
+        if (embedded && !connect(u, v))
+            embedded = false;
+        return true;
+    }
+
+    /*
+        drop erases the edge of half-edge h from the embedding.
+    */
+    void drop(int h)
+    {
+        rotation.erase(h);
+        rotation.erase(h ^ 1);
+        spare.push_back(h);
+    }
+
+    /*
+        chord adds the edge between the origins of hx and hy, two
+        half-edges on the same face, across that face.
+    */
+    void chord(int hx, int hy)
+    {
+        int x = rotation.origin(hx), y = rotation.origin(hy);
+        int h;
+        if (spare.empty())
+            h = rotation.add(x, y);
+        else {
+            h = rotation.reuse(spare.back(), x, y);
+            spare.pop_back();
+        }
+        rotation.insertCw(h, hx);
+        rotation.insertCw(h ^ 1, hy);
+        edges[key(x, y)] = (x < y ? h : h ^ 1);
+    }
+
+    /*
+        flip turns the edge (a, b) of half-edge h into (c, d), where
+        (a, b, c) and (b, a, d) are the faces on either side of it.
+    */
+    bool flip(int h)
+    {
+        int n1 = rotation.nextInFace(h), n2 = rotation.nextInFace(n1);
+        int m1 = rotation.nextInFace(h ^ 1), m2 = rotation.nextInFace(m1);
+        if (rotation.nextInFace(n2) != h || rotation.nextInFace(m2) != (h ^ 1))
+            return false;
+        int c = rotation.target[n1], d = rotation.target[m1];
+        if (c == d || edges.count(key(c, d)))
+            return false;
+        edges.erase(key(rotation.origin(h), rotation.target[h]));
+        drop(h);
+        // n2 runs from c and m2 from d around the merged face
+        chord(n2, m2);
+        return true;
+    }
+
+    /*
+        connect embeds the new edge (x, y) as a chord of a face around x
+        that has y on it. Returns false if there is none.
+    */
+    bool connect(int x, int y)
+    {
+        int h0 = rotation.first[x];
+        if (h0 == -1)
+            return false;
+        if (seen.size() < rotation.halfEdges())
+            seen.resize(rotation.halfEdges(), 0);
+        stamp++;
+        int h = h0;
+        do {
+            // faces through x twice are walked once
+            for (int g = h; seen[g] != stamp; g = rotation.nextInFace(g)) {
+                seen[g] = stamp;
+                if (rotation.origin(g) == y) {
+                    chord(h, g);
+                    return true;
+                }
+            }
+            h = rotation.cw[h];
+        } while (h != h0);
+        return false;
+    }
+
+    /*
+        recheck tests the graph in full and keeps the embedding found, if
+        any. Returns whether it is maximal planar.
+    */
+    bool recheck()
+    {
+        rechecks++;
+        vector<pair<int, int> > list;
+        edgeList(list);
+        graph.build(V, list);
+        embedded = maximal = false;
+        spare.clear();
+        if (list.size() == 3 * V - 6) {
+            Embedding embedding;
+            if (tester.isMaximalPlanar(graph, &embedding)) {
+                adopt(embedding);
+                embedded = maximal = true;
+            }
+        } else if (lr.isPlanar(graph)) {
+            rotation = lr.embedding();
+            for (int h = 0; h < rotation.halfEdges(); h += 2) {
+                int u = rotation.origin(h), v = rotation.target[h];
+                edges[key(u, v)] = (u < v ? h : h ^ 1);
+            }
+            embedded = true;
+        }
+        return maximal;
+    }
+
+    /*
+        adopt makes rotation the embedding found by the maximal planarity
+        test.
+    */
+    void adopt(const Embedding& embedding)
+    {
+        rotation.reset(V, edges.size());
+        for (int v = 0; v < V; v++)
+            for (int i = 0; i < embedding.degree(v); i++)
+                if (embedding.around(v)[i] > v)
+                    edges[key(v, embedding.around(v)[i])] = rotation.add(v, embedding.around(v)[i]);
+        for (int v = 0; v < V; v++) {
+            int last = -1;
+            for (int i = 0; i < embedding.degree(v); i++) {
+                int w = embedding.around(v)[i];
+                int h = edges[key(v, w)] ^ (v < w ? 0 : 1);
+                rotation.insertCw(h, last);
+                last = h;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+/*
+    FirstTriangle is the start shared by PlanarityTester (see
+    includes/planarity.hpp) and Recognizer (see includes/recognizer.hpp).
+    A maximal planar graph has E = 3V - 6 and a vertex v1 of degree p <= 5,
+    and the edge (v1, v2) to its last neighbour lies on a triangle with
+    one of the first p - 2 others. Each such triangle is tried as the
+    outer face of the canonical order:
+
+        FirstTriangle start;
+        if (start.find(graph) == START_FOUND)
+            for (int i = 0; i < start.candidates; i++)
+                if (start.candidate(i) != -1)
+                    ...
+*/
+#ifndef FIRST_TRIANGLE_HPP
+#define FIRST_TRIANGLE_HPP
+
+#include "csr_graph.hpp"
+#include "instrument.hpp"
+
+/*
+    START_FOUND      -> v1, v2 and candidates are set
+    START_EDGE_COUNT -> E != 3V - 6
+    START_MIN_DEGREE -> no vertex has degree <= 5 (v1 is -1), or v1, the
+                        first that does, has degree < 3
+*/
+enum StartResult {START_FOUND, START_EDGE_COUNT, START_MIN_DEGREE};
+
+struct FirstTriangle {
+    const Graph* graph;
+    int v1, v2, candidates;
+
+    FirstTriangle()
+    {
+        graph = NULL;
+        v1 = v2 = -1;
+        candidates = 0;
+    }
+
+    StartResult find(const Graph& g)
+    {
+        graph = &g;
+        v1 = v2 = -1;
+        candidates = 0;
+        if (g.E != 3 * g.V - 6)
+            return START_EDGE_COUNT;
+        v1 = getVertex();
+        if (v1 == -1)
+            return START_MIN_DEGREE;
+        int p = g.degree(v1);
+        // too few neighbours for v1 to lie on a triangle, and for v2
+        if (p < 3)
+            return START_MIN_DEGREE;
+        v2 = g.adj[g.offset[v1] + p - 1];
+        candidates = p - 2;
+        return START_FOUND;
+    }
+
+    /*
+        candidate returns the i-th neighbour vn of v1 if (v1, v2, vn) is a
+        triangle, or -1.
+    */
+    int candidate(int i) const
+    {
+        int vn = graph->adj[graph->offset[v1] + i];
+        if (instrument.traced())
+            instrument.trace("candidate", &vn, 1);
+        return isTriangle(v1, v2, vn) ? vn : -1;
+    }
+
+    /*
+        getVertex checks if the graph has a vertex with degree <= 5 and
+        returns the first one found. Otherwise, returns -1.
+    */
+    int getVertex() const
+    {
+        Probe probe(PROBE_GET_VERTEX);
+        for (int v = 0; v < graph->V; v++)
+            if (graph->degree(v) <= 5)
+                return v;
+        return -1;
+    }
+
+    /*
+        isTriangle checks if three vertices form a triangle.
+    */
+    bool isTriangle(int v1, int v2, int vn) const
+    {
+        Probe probe(PROBE_IS_TRIANGLE);
+        int count = 0;
+        for (int i = graph->offset[v1]; i < graph->offset[v1 + 1]; i++)
+            if (graph->adj[i] == v2 || graph->adj[i] == vn)
+                count++;
+
+        for (int i = graph->offset[v2]; i < graph->offset[v2 + 1]; i++)
+            if (graph->adj[i] == v1 || graph->adj[i] == vn)
+                count++;
+
+        return count == 4;
+    }
+};
+
+#endif
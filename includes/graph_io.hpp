@@ -0,0 +1,105 @@
+/*
+    Input formats understood by readGraph:
+
+    INPUT_DENSE -> V on the first line, followed by the upper triangular
+                   part of the weight matrix, row by row. -1 means that
+                   there is no edge.
+    INPUT_EDGES -> "V E" on the first line, followed by E lines "u v" or
+                   "u v w", with 0-based endpoints and an optional weight.
+                   Repeated edges are not allowed; loops and edges with
+                   endpoints out of range are dropped.
+    INPUT_AUTO  -> picks one of the above from the number of integers
+                   found on the first line.
+*/
+#ifndef GRAPH_IO_HPP
+#define GRAPH_IO_HPP
+
+#include "helpers.hpp"
+
+enum InputFormat { INPUT_AUTO, INPUT_DENSE, INPUT_EDGES };
+
+/*
+    parseFormat returns the input format selected by the command line
+    flags -d (--dense) or -e (--edges), or INPUT_AUTO.
+*/
+inline InputFormat parseFormat(int argc, char** argv)
+{
+    InputFormat format = INPUT_AUTO;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-d" || arg == "--dense")
+            format = INPUT_DENSE;
+        else if (arg == "-e" || arg == "--edges")
+            format = INPUT_EDGES;
+    }
+    return format;
+}
+
+/*
+    readGraph reads a graph from stdin as a list of edges (u, v), u < v,
+    and their weights. Edges without a weight get weight 1.
+    Returns false if the input is exhausted.
+*/
+inline bool readGraph(InputFormat format, int& V, vector<pair<int, int> >& edges, vector<int>& weights)
+{
+    vector<int> header;
+    edges.clear();
+    weights.clear();
+    if (readLine(header) == -1)
+        return false;
+
+    V = header[0];
+    if (V < 0)
+        return false;
+    if (format == INPUT_AUTO)
+        format = (header.size() >= 2 ? INPUT_EDGES : INPUT_DENSE);
+
+    if (format == INPUT_DENSE) {
+        // the matrix may start on the header line itself
+        int w, k = 1;
+        for (int i = 0; i < V - 1; i++) {
+            for (int j = i + 1; j < V; j++) {
+                if (k < header.size())
+                    w = header[k++];
+                else
+                    read(w);
+                if (w == -1)
+                    continue;
+                edges.push_back(make_pair(i, j));
+                weights.push_back(w);
+            }
+        }
+        return true;
+    }
+
+    // the first edge tells whether the list carries weights
+    int E = header.size() >= 2 ? header[1] : 0, u, v, w = 1;
+    if (E < 0)
+        return false;
+    vector<int> first;
+    if (E > 0 && readLine(first) < 2)
+        return false;
+    bool weighted = E > 0 && first.size() >= 3;
+    edges.reserve(E);
+    weights.reserve(E);
+    for (int i = 0; i < E; i++) {
+        if (i == 0) {
+            u = first[0];
+            v = first[1];
+            if (weighted)
+                w = first[2];
+        } else {
+            read(u);
+            read(v);
+            if (weighted)
+                read(w);
+        }
+        if (u == v || u < 0 || v < 0 || u >= V || v >= V)
+            continue;
+        edges.push_back(make_pair(min(u, v), max(u, v)));
+        weights.push_back(w);
+    }
+    return true;
+}
+
+#endif
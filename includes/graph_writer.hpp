@@ -0,0 +1,249 @@
+/*
+    Writer collects output in a large buffer and hands it to write(2) only
+    when the buffer is full or on flush(), so nothing is flushed per line
+    and integers are formatted without going through iostreams.
+
+    writeGraph writes a weighted graph given by its edges in one of the
+    OutputFormats:
+
+    OUTPUT_DENSE  -> the upper triangle of the weight matrix, -1 for
+                     missing edges, as read by readGraph. An edge of
+                     weight -1 cannot be told from a missing one, so
+                     graphs with such edges are refused
+    OUTPUT_EDGES  -> "V E" and then one "u v w" line per edge, also as
+                     read by readGraph
+    OUTPUT_BINARY -> the weighted binary graph of
+                     includes/binary_graph.hpp
+*/
+#ifndef GRAPH_WRITER_HPP
+#define GRAPH_WRITER_HPP
+
+#include <unistd.h>
+#include <cstring>
+
+#include "binary_graph.hpp"
+
+enum OutputFormat { OUTPUT_DENSE, OUTPUT_EDGES, OUTPUT_BINARY };
+
+/*
+    parseOutputFormat returns the format asked for with --out dense,
+    --out edges or --out binary, or OUTPUT_DENSE.
+*/
+inline OutputFormat parseOutputFormat(int argc, char** argv)
+{
+    for (int i = 1; i + 1 < argc; i++) {
+        if (string(argv[i]) != "--out")
+            continue;
+        string name = argv[i + 1];
+        if (name == "edges")
+            return OUTPUT_EDGES;
+        if (name == "binary")
+            return OUTPUT_BINARY;
+    }
+    return OUTPUT_DENSE;
+}
+
+struct Writer {
+    int fd;
+    vector<char> buf;
+    // used -> bytes of buf waiting to be written
+    size_t used;
+
+    Writer(int out, size_t size = 1 << 22)
+    {
+        fd = out;
+        buf.resize(size);
+        used = 0;
+    }
+
+    ~Writer()
+    {
+        flush();
+    }
+
+    void flush()
+    {
+        writeAll(&buf[0], used);
+        used = 0;
+    }
+
+    /*
+        room makes sure the next n bytes, at most buf.size(), fit in
+        the buffer.
+    */
+    void room(size_t n)
+    {
+        if (used + n > buf.size())
+            flush();
+    }
+
+    void putChar(char c)
+    {
+        room(1);
+        buf[used++] = c;
+    }
+
+    void putStr(const char* s)
+    {
+        putRaw(s, strlen(s));
+    }
+
+    /*
+        putRaw copies n bytes from p. Blocks larger than the buffer,
+        such as the arrays of a binary graph, skip it.
+    */
+    void putRaw(const void* p, size_t n)
+    {
+        if (n > buf.size()) {
+            flush();
+            writeAll((const char*)p, n);
+            return;
+        }
+        room(n);
+        memcpy(&buf[used], p, n);
+        used += n;
+    }
+
+    /*
+        putInt writes x in decimal, two digits at a time.
+    */
+    void putInt(int x)
+    {
+        static const char pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        room(12);
+        char* p = &buf[used];
+        unsigned u = x;
+        if (x < 0) {
+            *p++ = '-';
+            u = 0u - u;
+        }
+        char tmp[10];
+        int k = 10;
+        while (u >= 100) {
+            unsigned q = u / 100, r = u - q * 100;
+            tmp[--k] = pairs[2 * r + 1];
+            tmp[--k] = pairs[2 * r];
+            u = q;
+        }
+        if (u >= 10) {
+            tmp[--k] = pairs[2 * u + 1];
+            tmp[--k] = pairs[2 * u];
+        } else
+            tmp[--k] = '0' + u;
+        memcpy(p, tmp + k, 10 - k);
+        used = p + (10 - k) - &buf[0];
+    }
+
+private:
+    void writeAll(const char* p, size_t n)
+    {
+        size_t done = 0;
+        while (done < n) {
+            ssize_t k = write(fd, p + done, n - done);
+            if (k <= 0)
+                break;
+            done += k;
+        }
+    }
+
+    Writer(const Writer&);
+    Writer& operator=(const Writer&);
+};
+
+/*
+    writeBinaryGraph writes the graph with V vertices and the given
+    edges, edge i having weight weights[i], as a weighted binary graph.
+    Edges must have u < v and be sorted.
+*/
+inline void writeBinaryGraph(Writer& out, int V, const vector<pair<int, int> >& edges, const vector<int>& weights)
+{
+    int E = edges.size();
+    BinaryHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, BINARY_MAGIC, 4);
+    h.version = BINARY_VERSION;
+    h.flags = BINARY_WEIGHTED;
+    h.V = V;
+    h.E = E;
+
+    vector<int> offset(V + 1, 0), adj(2 * E), slotWeights(2 * E);
+    for (int i = 0; i < E; i++) {
+        offset[edges[i].first + 1]++;
+        offset[edges[i].second + 1]++;
+    }
+    for (int v = 0; v < V; v++)
+        offset[v + 1] += offset[v];
+
+    // going through the sorted edges, every vertex meets its lower
+    // neighbours in order before its higher ones, so the lists come
+    // out sorted
+    vector<int> at(offset.begin(), offset.end() - 1);
+    for (int i = 0; i < E; i++) {
+        int u = edges[i].first, v = edges[i].second;
+        adj[at[u]] = v;
+        slotWeights[at[u]++] = weights[i];
+        adj[at[v]] = u;
+        slotWeights[at[v]++] = weights[i];
+    }
+
+    out.putRaw(&h, sizeof(h));
+    out.putRaw(&offset[0], (V + 1) * sizeof(int));
+    if (E) {
+        out.putRaw(&adj[0], 2 * E * sizeof(int));
+        out.putRaw(&slotWeights[0], 2 * E * sizeof(int));
+    }
+}
+
+/*
+    writeGraph writes the graph with V vertices and the given edges,
+    edge i having weight weights[i]. Edges must have u < v and be sorted.
+    Returns false, writing nothing, if the format cannot hold the graph.
+*/
+inline bool writeGraph(Writer& out, OutputFormat format, int V, const vector<pair<int, int> >& edges, const vector<int>& weights)
+{
+    int E = edges.size();
+    if (format == OUTPUT_BINARY) {
+        writeBinaryGraph(out, V, edges, weights);
+        return true;
+    }
+
+    if (format == OUTPUT_EDGES) {
+        out.putInt(V);
+        out.putChar(' ');
+        out.putInt(E);
+        out.putChar('\n');
+        for (int i = 0; i < E; i++) {
+            out.putInt(edges[i].first);
+            out.putChar(' ');
+            out.putInt(edges[i].second);
+            out.putChar(' ');
+            out.putInt(weights[i]);
+            out.putChar('\n');
+        }
+        return true;
+    }
+
+    if (count(weights.begin(), weights.end(), -1))
+        return false;
+
+    // each row of the matrix lists the weights to the higher vertices,
+    // most of them the -1 of a missing edge
+    out.putInt(V);
+    out.putChar('\n');
+    for (int i = 0, e = 0; i < V; i++) {
+        for (int j = i + 1; j < V; j++) {
+            if (e < E && edges[e].first == i && edges[e].second == j) {
+                out.putInt(weights[e++]);
+                out.putChar(' ');
+            } else
+                out.putRaw("-1 ", 3);
+        }
+        out.putChar('\n');
+    }
+    return true;
+}
+
+#endif
@@ -1,4 +1,7 @@
-void printElapsedTime(clock_t start, clock_t stop)
+#ifndef HELPERS_HPP
+#define HELPERS_HPP
+
+inline void printElapsedTime(clock_t start, clock_t stop)
 {
     double elapsed = ((double)(stop - start)) / CLOCKS_PER_SEC;
     cout << fixed << setprecision(3) << "Elapsed time: " << elapsed << "s\n";
@@ -7,7 +10,7 @@ void printElapsedTime(clock_t start, clock_t stop)
 /*
     read is a fast input implementation.
 */
-bool read(int& n)
+inline bool read(int& n)
 {
     n = 0;
     register bool neg = false;
@@ -27,4 +30,35 @@ bool read(int& n)
     }
     n = (neg ? (-n) : (n));
     return true;
-}
\ No newline at end of file
+}
+
+/*
+    readLine reads the integers of the next non-empty input line into
+    vals and returns how many were found, or -1 at the end of the input.
+*/
+inline int readLine(vector<int>& vals)
+{
+    vals.clear();
+    int c = getchar_unlocked();
+    while (c != EOF && vals.empty()) {
+        while (c != EOF && c != '\n') {
+            if (c == '-' || ('0' <= c && c <= '9')) {
+                bool neg = (c == '-');
+                int n = 0;
+                if (neg)
+                    c = getchar_unlocked();
+                while ('0' <= c && c <= '9') {
+                    n = n * 10 + c - '0';
+                    c = getchar_unlocked();
+                }
+                vals.push_back(neg ? -n : n);
+            } else
+                c = getchar_unlocked();
+        }
+        if (c == '\n' && vals.empty())
+            c = getchar_unlocked();
+    }
+    return vals.empty() ? -1 : vals.size();
+}
+
+#endif
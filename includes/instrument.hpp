@@ -0,0 +1,315 @@
+/*
+    Instrument times the hot sections of the testers and collects their
+    trace. A section is measured by a Probe living in its scope:
+
+        {
+            Probe probe(PROBE_ORDER);
+            ...
+        }
+
+    Sections nest, so the time of a candidate triangle includes the order
+    and embed calls made for it. When the kernel allows it, the cycles,
+    instructions, cache misses and branch misses of the calling thread
+    are read from perf events along with the steady_clock time.
+
+    Nothing is measured until enable() is called, and until then a probe
+    costs one well predicted branch. Compiling with -DNO_INSTRUMENT removes
+    the probes and the trace altogether.
+
+    report() writes one JSON object with the totals of every section that
+    ran and the trace events, if any.
+*/
+#ifndef INSTRUMENT_HPP
+#define INSTRUMENT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum Section {
+    PROBE_PARSE,
+    PROBE_SORT,
+    PROBE_GET_VERTEX,
+    PROBE_IS_TRIANGLE,
+    PROBE_ORDER,
+    PROBE_EMBED,
+    PROBE_TRIANGLE,
+    PROBE_SECTIONS
+};
+
+static const char* const sectionNames[PROBE_SECTIONS] = {
+    "parse", "sort", "get_vertex", "is_triangle", "order", "embed", "triangle"
+};
+
+const int HW_COUNTERS = 4;
+static const char* const counterNames[HW_COUNTERS] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+/*
+    HardwareCounters is a perf event group counting, for the thread that
+    opened it, the events of counterNames. ok is false when the group
+    could not be opened, e.g. under a restrictive perf_event_paranoid.
+*/
+struct HardwareCounters {
+    int fd[HW_COUNTERS];
+    bool ok;
+
+    HardwareCounters()
+    {
+        ok = false;
+        for (int i = 0; i < HW_COUNTERS; i++)
+            fd[i] = -1;
+    }
+
+    ~HardwareCounters()
+    {
+        for (int i = 0; i < HW_COUNTERS; i++)
+            if (fd[i] != -1)
+                ::close(fd[i]);
+    }
+
+    void open()
+    {
+#ifdef __linux__
+        unsigned long long config[HW_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for (int i = 0; i < HW_COUNTERS; i++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = config[i];
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, i ? fd[0] : -1, 0);
+            if (fd[i] == -1)
+                return;
+        }
+        ok = true;
+#endif
+    }
+
+    /*
+        sample stores the current value of every counter in values,
+        or zeros when the counters are not available.
+    */
+    void sample(long long* values)
+    {
+        // the group is read at once as {count, value_0, ..., value_n-1}
+        long long group[HW_COUNTERS + 1];
+        if (!ok || ::read(fd[0], group, sizeof(group)) != sizeof(group)) {
+            memset(values, 0, HW_COUNTERS * sizeof(long long));
+            return;
+        }
+        memcpy(values, group + 1, HW_COUNTERS * sizeof(long long));
+    }
+
+private:
+    HardwareCounters(const HardwareCounters&);
+    HardwareCounters& operator=(const HardwareCounters&);
+};
+
+struct Instrument {
+    struct Totals {
+        long calls;
+        double seconds;
+        long long counters[HW_COUNTERS];
+    };
+
+    /*
+        timing   -> probes measure their sections
+        counting -> probes also read the hardware counters
+        counted  -> some probe did read them, so they go in the report
+        tracing  -> trace() records its events
+    */
+    bool timing, counting, counted, tracing;
+    Totals totals[PROBE_SECTIONS];
+    vector<string> events;
+    mutex lock;
+
+    Instrument()
+    {
+        timing = counting = counted = tracing = false;
+        memset(totals, 0, sizeof(totals));
+    }
+
+    /*
+        enable turns on the probes, and the hardware counters with them
+        when counters is true.
+    */
+    void enable(bool counters)
+    {
+        timing = true;
+        counting = counters;
+    }
+
+#ifdef NO_INSTRUMENT
+    bool on() const { return false; }
+    bool traced() const { return false; }
+#else
+    bool on() const { return timing; }
+    bool traced() const { return tracing; }
+#endif
+
+    /*
+        add adds a call of s to the totals, with the counter deltas when
+        counters is not NULL.
+    */
+    void add(Section s, double seconds, const long long* counters)
+    {
+        lock_guard<mutex> guard(lock);
+        totals[s].calls++;
+        totals[s].seconds += seconds;
+        if (!counters)
+            return;
+        counted = true;
+        for (int i = 0; i < HW_COUNTERS; i++)
+            totals[s].counters[i] += counters[i];
+    }
+
+    /*
+        trace records the event what about the n given vertices.
+        Callers check traced() first, so that a production run does not
+        even build the arguments.
+    */
+    void trace(const char* what, const int* vertices, int n)
+    {
+        string event = string("{\"event\": \"") + what + "\", \"vertices\": [";
+        char buf[16];
+        for (int i = 0; i < n; i++) {
+            sprintf(buf, i ? ", %d" : "%d", vertices[i]);
+            event += buf;
+        }
+        event += "]}";
+        lock_guard<mutex> guard(lock);
+        events.push_back(event);
+    }
+
+    /*
+        report writes the totals of the sections that ran and the trace
+        to out as a single JSON object.
+    */
+    void report(FILE* out)
+    {
+        lock_guard<mutex> guard(lock);
+        fprintf(out, "{\"sections\": {");
+        bool first = true;
+        for (int s = 0; s < PROBE_SECTIONS; s++) {
+            if (!totals[s].calls)
+                continue;
+            fprintf(out, "%s\"%s\": {\"calls\": %ld, \"seconds\": %.9f", first ? "" : ", ",
+                sectionNames[s], totals[s].calls, totals[s].seconds);
+            if (counted)
+                for (int i = 0; i < HW_COUNTERS; i++)
+                    fprintf(out, ", \"%s\": %lld", counterNames[i], totals[s].counters[i]);
+            fprintf(out, "}");
+            first = false;
+        }
+        fprintf(out, "}, \"trace\": [");
+        for (int i = 0; i < events.size(); i++)
+            fprintf(out, "%s%s", i ? ", " : "", events[i].c_str());
+        fprintf(out, "]}\n");
+    }
+};
+
+/*
+    sharedInstrument returns the one Instrument of the program, whatever
+    translation unit asks for it; instrument refers to it in each of
+    them, so this header can be included by several files linked together.
+*/
+inline Instrument& sharedInstrument()
+{
+    static Instrument shared;
+    return shared;
+}
+
+static Instrument& instrument = sharedInstrument();
+
+/*
+    threadCounters returns the hardware counters of the calling thread,
+    opening them the first time.
+*/
+inline HardwareCounters& threadCounters()
+{
+    static thread_local HardwareCounters counters;
+    static thread_local bool opened = false;
+    if (!opened) {
+        counters.open();
+        opened = true;
+    }
+    return counters;
+}
+
+#ifdef NO_INSTRUMENT
+struct Probe {
+    Probe(Section s) {}
+};
+#else
+struct Probe {
+    Section section;
+    bool active, counted;
+    chrono::steady_clock::time_point start;
+    long long counters[HW_COUNTERS];
+
+    Probe(Section s)
+    {
+        section = s;
+        active = instrument.on();
+        if (!active)
+            return;
+        counted = instrument.counting && threadCounters().ok;
+        if (counted)
+            threadCounters().sample(counters);
+        start = chrono::steady_clock::now();
+    }
+
+    ~Probe()
+    {
+        if (!active)
+            return;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        long long now[HW_COUNTERS];
+        if (counted) {
+            threadCounters().sample(now);
+            for (int i = 0; i < HW_COUNTERS; i++)
+                now[i] -= counters[i];
+        }
+        instrument.add(section, seconds, counted ? now : NULL);
+    }
+};
+#endif
+
+/*
+    parseInstrument turns on the instrumentation asked for by the command
+    line: --profile times the sections, and reads the hardware counters
+    too unless --no-counters is given; --trace records the trace. Returns
+    whether a report is due at the end of the run.
+*/
+inline bool parseInstrument(int argc, char** argv)
+{
+    bool profile = false, counters = true;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--profile")
+            profile = true;
+        else if (arg == "--no-counters")
+            counters = false;
+        else if (arg == "--trace")
+            instrument.tracing = true;
+    }
+    if (profile)
+        instrument.enable(counters);
+    return profile || instrument.tracing;
+}
+
+#endif
@@ -0,0 +1,767 @@
+/*
+    LrPlanarity decides whether an arbitrary graph is planar, in linear
+    time, with the left-right test of de Fraysseix and Rosenstiehl in the
+    form given by Brandes (2009), "The Left-Right Planarity Test". Unlike
+    PlanarityTester (see includes/planarity.hpp) it needs no particular
+    edge count, so it answers for the sparse graphs the maximal planarity
+    test always rejects.
+
+        LrPlanarity lr;
+        bool yes = lr.isPlanar(graph);
+
+    A planar graph is embedded along the way, and given a vector, the
+    test also returns the edges that make it maximal planar while keeping
+    it simple. The graph with those edges added passes the maximal
+    planarity test, which is how the augmentation is checked.
+
+    The three depth-first searches of the test (orientation, testing and
+    embedding) run on explicit stacks, so paths of any length fit. The
+    graph must not contain loops or duplicate edges, as Graph::build()
+    already requires.
+*/
+#ifndef LR_PLANARITY_HPP
+#define LR_PLANARITY_HPP
+
+#include <unordered_set>
+
+#include "csr_graph.hpp"
+
+/*
+    RotationSystem holds a planar embedding that can still change. Edge e
+    is split into the half-edges 2e and 2e + 1, each other's twin:
+    half-edge h leaves origin(h) for target[h], and cw[h], ccw[h] are the
+    half-edges leaving the same vertex next to h clockwise and
+    counter-clockwise. first[v] is a half-edge leaving v, -1 if none does.
+
+    The face on the left of h goes on with nextInFace(h).
+*/
+struct RotationSystem {
+    vector<int> target, cw, ccw, first;
+
+    void reset(int n, int edges)
+    {
+        target.clear();
+        cw.clear();
+        ccw.clear();
+        target.reserve(2 * edges);
+        cw.reserve(2 * edges);
+        ccw.reserve(2 * edges);
+        first.assign(n, -1);
+    }
+
+    int halfEdges() const
+    {
+        return target.size();
+    }
+
+    int origin(int h) const
+    {
+        return target[h ^ 1];
+    }
+
+    int nextInFace(int h) const
+    {
+        return ccw[h ^ 1];
+    }
+
+    /*
+        add creates the edge (u, v) and returns its half-edge from u. Its
+        two half-edges still have to be placed with the insert functions.
+    */
+    int add(int u, int v)
+    {
+        target.push_back(v);
+        target.push_back(u);
+        for (int i = 0; i < 2; i++) {
+            cw.push_back(-1);
+            ccw.push_back(-1);
+        }
+        return target.size() - 2;
+    }
+
+    /*
+        reuse gives the slots of the erased edge of half-edge h to the
+        edge (u, v), and returns its half-edge from u.
+    */
+    int reuse(int h, int u, int v)
+    {
+        h &= ~1;
+        target[h] = v;
+        target[h + 1] = u;
+        return h;
+    }
+
+    /*
+        insertCw places h right after ref clockwise around their origin.
+        ref == -1 means h is the first half-edge there.
+    */
+    void insertCw(int h, int ref)
+    {
+        if (ref == -1) {
+            cw[h] = ccw[h] = h;
+            first[origin(h)] = h;
+            return;
+        }
+        int next = cw[ref];
+        cw[ref] = h;
+        ccw[h] = ref;
+        cw[h] = next;
+        ccw[next] = h;
+    }
+
+    /*
+        insertCcw places h right after ref counter-clockwise.
+    */
+    void insertCcw(int h, int ref)
+    {
+        insertCw(h, ref == -1 ? -1 : ccw[ref]);
+    }
+
+    /*
+        erase takes h out of the rotation around its origin. The slots
+        stay, and reuse() can give them to another edge.
+    */
+    void erase(int h)
+    {
+        int o = origin(h);
+        if (cw[h] == h) {
+            first[o] = -1;
+            return;
+        }
+        cw[ccw[h]] = cw[h];
+        ccw[cw[h]] = ccw[h];
+        if (first[o] == h)
+            first[o] = cw[h];
+    }
+
+    /*
+        insertFirst places h right before first[origin(h)] clockwise and
+        makes it the first half-edge of its origin.
+    */
+    void insertFirst(int h)
+    {
+        insertCcw(h, first[origin(h)]);
+        first[origin(h)] = h;
+    }
+};
+
+class LrPlanarity {
+public:
+    LrPlanarity()
+    {
+        graph = NULL;
+        V = E = 0;
+    }
+
+    /*
+        isPlanar tests g and, when it is planar and augmentation is not
+        NULL, stores there the edges (u, v), u < v, that make it maximal
+        planar: for fewer than 3 vertices, the edge of K2 if it is
+        missing.
+    */
+    bool isPlanar(const Graph& g, vector<pair<int, int> >* augmentation = NULL)
+    {
+        graph = &g;
+        V = g.V;
+        E = g.E;
+        bool ans = (V <= 2 || E <= 3 * V - 6) && test();
+        if (ans && augmentation)
+            augment(*augmentation);
+        graph = NULL;
+        return ans;
+    }
+
+    /*
+        embedding returns the rotation system of the last planar graph,
+        with the edges of the augmentation when one was asked for, which
+        makes every face of it a triangle.
+    */
+    const RotationSystem& embedding() const
+    {
+        return rotation;
+    }
+
+private:
+    /*
+        Interval is a run of return edges on one side, from high, the one
+        returning highest, down to low. Empty when both are -1.
+
+        ConflictPair is the left and the right interval of a set of return
+        edges that constrain each other. id tells pairs apart, since the
+        stack holds copies: stackBottom remembers the id of the pair on
+        top when an edge was entered, -1 for an empty stack.
+    */
+    struct Interval {
+        int low, high;
+
+        Interval(int l = -1, int h = -1)
+        {
+            low = l;
+            high = h;
+        }
+
+        bool empty() const
+        {
+            return low == -1 && high == -1;
+        }
+    };
+
+    struct ConflictPair {
+        Interval left, right;
+        int id;
+
+        void swap()
+        {
+            Interval t = left;
+            left = right;
+            right = t;
+        }
+    };
+
+    /*
+        Edges are numbered by the first slot of the adjacency holding
+        them, and oriented from tail to head by the first search, tree
+        edges downwards and back edges upwards. For the edges:
+
+        lowpt, lowpt2 -> the lowest and second lowest heights reached by
+                         the return edges of the edge's subtree
+        nesting       -> the nesting depth, from lowpt and lowpt2 first,
+                         signed by the side of the edge at the end
+        ref, side     -> the side relative to edge ref, or absolute (1
+                         right, -1 left) once ref is -1
+        lowptEdge     -> the return edge reaching lowpt
+        stackBottom   -> see ConflictPair
+        block         -> biconnected component, for the augmentation,
+                         leader being the union-find over them
+
+        And for the vertices:
+
+        height     -> depth in the DFS forest, -1 while unvisited
+        parentEdge -> tree edge entering the vertex, -1 for the roots
+        leftRef, rightRef -> the half-edges next to which the back edges
+                     returning to the vertex are embedded
+        out        -> the edges leaving each vertex, from outOffset,
+                      sorted by nesting depth
+        at         -> next edge of each vertex to look at in a search
+    */
+    const Graph* graph;
+    int V, E;
+    vector<int> slotEdge, tail, head;
+    vector<int> lowpt, lowpt2, nesting, ref, side, lowptEdge, stackBottom, block;
+    vector<int> height, parentEdge, leftRef, rightRef;
+    vector<int> outOffset, out, at, roots, preorder;
+    vector<int> dfs, chain, count, sorted, leader;
+    vector<char> skip;
+    vector<ConflictPair> S;
+    int pairs;
+    RotationSystem rotation;
+
+    /*
+        test runs the three phases of the algorithm, leaving the
+        embedding in rotation when the graph is planar.
+    */
+    bool test()
+    {
+        numberEdges();
+        height.assign(V, -1);
+        parentEdge.assign(V, -1);
+        lowpt.assign(E, 0);
+        lowpt2.assign(E, 0);
+        nesting.assign(E, 0);
+        tail.assign(E, -1);
+        head.assign(E, -1);
+        roots.clear();
+        preorder.clear();
+        at.assign(graph->offset, graph->offset + V);
+        skip.assign(E, 0);
+        for (int v = 0; v < V; v++)
+            if (height[v] == -1) {
+                height[v] = 0;
+                roots.push_back(v);
+                preorder.push_back(v);
+                orient(v);
+            }
+
+        sortOut(0);
+        ref.assign(E, -1);
+        side.assign(E, 1);
+        lowptEdge.assign(E, -1);
+        stackBottom.assign(E, -1);
+        S.clear();
+        pairs = 0;
+        at.assign(outOffset.begin(), outOffset.end() - 1);
+        skip.assign(E, 0);
+        for (int i = 0; i < roots.size(); i++)
+            if (!testFrom(roots[i]))
+                return false;
+
+        for (int e = 0; e < E; e++)
+            nesting[e] *= sign(e);
+        sortOut(2 * V + 2);
+        rotation.reset(V, E);
+        for (int e = 0; e < E; e++)
+            rotation.add(tail[e], head[e]);
+        for (int v = 0; v < V; v++)
+            for (int i = outOffset[v]; i < outOffset[v + 1]; i++)
+                rotation.insertCw(2 * out[i], i == outOffset[v] ? -1 : 2 * out[i - 1]);
+        leftRef.assign(V, -1);
+        rightRef.assign(V, -1);
+        at.assign(outOffset.begin(), outOffset.end() - 1);
+        for (int i = 0; i < roots.size(); i++)
+            embedFrom(roots[i]);
+        return true;
+    }
+
+    /*
+        numberEdges gives every edge the number of its slot in the
+        adjacency of its smaller end, kept in slotEdge for both slots and
+        then compacted to 0, ..., E - 1.
+    */
+    void numberEdges()
+    {
+        slotEdge.assign(2 * E, -1);
+        int next = 0;
+        for (int v = 0; v < V; v++)
+            for (int i = graph->offset[v]; i < graph->offset[v + 1]; i++) {
+                int w = graph->adj[i];
+                if (w > v) {
+                    slotEdge[i] = next++;
+                    continue;
+                }
+                const int* begin = graph->adj + graph->offset[w];
+                const int* end = graph->adj + graph->offset[w + 1];
+                slotEdge[i] = slotEdge[lower_bound(begin, end, v) - graph->adj];
+            }
+    }
+
+    /*
+        orient is the first search from root: it orients the edges,
+        computes their lowpoints and nesting depths and records the
+        vertices in preorder. A vertex is pushed back under its child
+        and resumes at the tree edge it left by.
+    */
+    void orient(int root)
+    {
+        dfs.clear();
+        dfs.push_back(root);
+        while (!dfs.empty()) {
+            int v = dfs.back();
+            dfs.pop_back();
+            int e = parentEdge[v];
+            for (; at[v] < graph->offset[v + 1]; at[v]++) {
+                int w = graph->adj[at[v]], vw = slotEdge[at[v]];
+                if (!skip[vw]) {
+                    // oriented from the other end
+                    if (tail[vw] != -1)
+                        continue;
+                    tail[vw] = v;
+                    head[vw] = w;
+                    lowpt[vw] = lowpt2[vw] = height[v];
+                    if (height[w] == -1) {
+                        parentEdge[w] = vw;
+                        height[w] = height[v] + 1;
+                        preorder.push_back(w);
+                        skip[vw] = 1;
+                        dfs.push_back(v);
+                        dfs.push_back(w);
+                        break;
+                    }
+                    lowpt[vw] = height[w];
+                }
+
+                nesting[vw] = 2 * lowpt[vw] + (lowpt2[vw] < height[v] ? 1 : 0);
+                if (e == -1)
+                    continue;
+                if (lowpt[vw] < lowpt[e]) {
+                    lowpt2[e] = min(lowpt[e], lowpt2[vw]);
+                    lowpt[e] = lowpt[vw];
+                } else if (lowpt[vw] > lowpt[e])
+                    lowpt2[e] = min(lowpt2[e], lowpt[vw]);
+                else
+                    lowpt2[e] = min(lowpt2[e], lowpt2[vw]);
+            }
+        }
+    }
+
+    /*
+        sortOut lists the edges leaving each vertex in out, by increasing
+        nesting + shift, with a counting sort over all edges.
+    */
+    void sortOut(int shift)
+    {
+        int keys = 4 * V + 6;
+        count.assign(keys + 1, 0);
+        for (int e = 0; e < E; e++)
+            count[nesting[e] + shift + 1]++;
+        for (int k = 0; k < keys; k++)
+            count[k + 1] += count[k];
+        sorted.resize(E);
+        for (int e = 0; e < E; e++)
+            sorted[count[nesting[e] + shift]++] = e;
+
+        outOffset.assign(V + 1, 0);
+        for (int e = 0; e < E; e++)
+            outOffset[tail[e] + 1]++;
+        for (int v = 0; v < V; v++)
+            outOffset[v + 1] += outOffset[v];
+        at.assign(outOffset.begin(), outOffset.end() - 1);
+        out.resize(E);
+        for (int i = 0; i < E; i++)
+            out[at[tail[sorted[i]]]++] = sorted[i];
+    }
+
+    int topId() const
+    {
+        return S.empty() ? -1 : S.back().id;
+    }
+
+    ConflictPair newPair(Interval right = Interval())
+    {
+        ConflictPair p;
+        p.right = right;
+        p.id = pairs++;
+        return p;
+    }
+
+    bool conflicting(const Interval& i, int b) const
+    {
+        return !i.empty() && lowpt[i.high] > lowpt[b];
+    }
+
+    int lowest(const ConflictPair& p) const
+    {
+        if (p.left.empty())
+            return lowpt[p.right.low];
+        if (p.right.empty())
+            return lowpt[p.left.low];
+        return min(lowpt[p.left.low], lowpt[p.right.low]);
+    }
+
+    /*
+        testFrom is the second search from root, which fits the return
+        edges of every subtree into the conflict pairs of S. Returns
+        false as soon as two of them cannot be on opposite sides.
+    */
+    bool testFrom(int root)
+    {
+        dfs.clear();
+        dfs.push_back(root);
+        while (!dfs.empty()) {
+            int v = dfs.back();
+            dfs.pop_back();
+            int e = parentEdge[v];
+            bool entered = false;
+            for (; at[v] < outOffset[v + 1]; at[v]++) {
+                int ei = out[at[v]], w = head[ei];
+                if (!skip[ei]) {
+                    stackBottom[ei] = topId();
+                    if (ei == parentEdge[w]) {
+                        skip[ei] = 1;
+                        entered = true;
+                        dfs.push_back(v);
+                        dfs.push_back(w);
+                        break;
+                    }
+                    lowptEdge[ei] = ei;
+                    S.push_back(newPair(Interval(ei, ei)));
+                }
+
+                // integrate the new return edges
+                if (lowpt[ei] < height[v]) {
+                    if (at[v] == outOffset[v])
+                        lowptEdge[e] = lowptEdge[ei];
+                    else if (!addConstraints(ei, e))
+                        return false;
+                }
+            }
+            if (!entered && e != -1)
+                removeBackEdges(e);
+        }
+        return true;
+    }
+
+    /*
+        addConstraints merges the return edges of ei into one conflict
+        pair with those of the earlier edges leaving the same vertex that
+        they conflict with.
+    */
+    bool addConstraints(int ei, int e)
+    {
+        ConflictPair p = newPair();
+        // the return edges of ei go right
+        do {
+            ConflictPair q = S.back();
+            S.pop_back();
+            if (!q.left.empty())
+                q.swap();
+            if (!q.left.empty())
+                return false;
+            if (lowpt[q.right.low] > lowpt[e]) {
+                if (p.right.empty())
+                    p.right = q.right;
+                else
+                    ref[p.right.low] = q.right.high;
+                p.right.low = q.right.low;
+            } else
+                ref[q.right.low] = lowptEdge[e];
+        } while (topId() != stackBottom[ei]);
+
+        // the conflicting ones of the earlier edges go left
+        while (!S.empty() && (conflicting(S.back().left, ei) || conflicting(S.back().right, ei))) {
+            ConflictPair q = S.back();
+            S.pop_back();
+            if (conflicting(q.right, ei))
+                q.swap();
+            if (conflicting(q.right, ei))
+                return false;
+            if (p.right.low != -1)
+                ref[p.right.low] = q.right.high;
+            if (q.right.low != -1)
+                p.right.low = q.right.low;
+
+            if (p.left.empty())
+                p.left = q.left;
+            else if (p.left.low != -1)
+                ref[p.left.low] = q.left.high;
+            p.left.low = q.left.low;
+        }
+
+        if (!p.left.empty() || !p.right.empty())
+            S.push_back(p);
+        return true;
+    }
+
+    /*
+        removeBackEdges drops the return edges ending at the tail of e
+        once its subtree is done, and sets the reference of e to the
+        highest return edge left.
+    */
+    void removeBackEdges(int e)
+    {
+        int u = tail[e];
+        while (!S.empty() && lowest(S.back()) == height[u]) {
+            if (S.back().left.low != -1)
+                side[S.back().left.low] = -1;
+            S.pop_back();
+        }
+
+        if (!S.empty()) {
+            ConflictPair& p = S.back();
+            while (p.left.high != -1 && head[p.left.high] == u)
+                p.left.high = ref[p.left.high];
+            if (p.left.high == -1 && p.left.low != -1) {
+                ref[p.left.low] = p.right.low;
+                side[p.left.low] = -1;
+                p.left.low = -1;
+            }
+            while (p.right.high != -1 && head[p.right.high] == u)
+                p.right.high = ref[p.right.high];
+            if (p.right.high == -1 && p.right.low != -1) {
+                ref[p.right.low] = p.left.low;
+                side[p.right.low] = -1;
+                p.right.low = -1;
+            }
+        }
+
+        // e goes on the side of a highest return edge
+        if (lowpt[e] < height[u]) {
+            int hl = S.back().left.high, hr = S.back().right.high;
+            ref[e] = (hl != -1 && (hr == -1 || lowpt[hl] > lowpt[hr]) ? hl : hr);
+        }
+    }
+
+    /*
+        sign resolves the side of e through its chain of references.
+    */
+    int sign(int e)
+    {
+        chain.clear();
+        for (int f = e; ref[f] != -1; f = ref[f])
+            chain.push_back(f);
+        for (int i = (int)chain.size() - 1; i >= 0; i--) {
+            side[chain[i]] *= side[ref[chain[i]]];
+            ref[chain[i]] = -1;
+        }
+        return side[e];
+    }
+
+    /*
+        embedFrom is the last search from root. The edges leaving each
+        vertex are already in place, by signed nesting depth; it adds
+        the half-edges entering the vertices: the tree edge first, and
+        each back edge next to the tree edge its subtree hangs from, on
+        the side the test gave it.
+    */
+    void embedFrom(int root)
+    {
+        dfs.clear();
+        dfs.push_back(root);
+        while (!dfs.empty()) {
+            int v = dfs.back();
+            dfs.pop_back();
+            while (at[v] < outOffset[v + 1]) {
+                int ei = out[at[v]++], w = head[ei];
+                if (ei == parentEdge[w]) {
+                    rotation.insertFirst(2 * ei + 1);
+                    leftRef[v] = rightRef[v] = 2 * ei;
+                    dfs.push_back(v);
+                    dfs.push_back(w);
+                    break;
+                }
+                if (side[ei] == 1)
+                    rotation.insertCw(2 * ei + 1, rightRef[w]);
+                else {
+                    rotation.insertCcw(2 * ei + 1, leftRef[w]);
+                    leftRef[w] = 2 * ei + 1;
+                }
+            }
+        }
+    }
+
+    int findBlock(int b)
+    {
+        while (leader[b] != b)
+            b = leader[b] = leader[leader[b]];
+        return b;
+    }
+
+    /*
+        join adds the edge (u, v) of block b to the rotation and to
+        added, and returns its half-edge from u.
+    */
+    int join(int u, int v, int b, vector<pair<int, int> >& added)
+    {
+        block.push_back(b);
+        added.push_back(make_pair(min(u, v), max(u, v)));
+        return rotation.add(u, v);
+    }
+
+    /*
+        augment makes the embedded graph maximal planar, in three steps
+        that each keep it embedded:
+
+        1. the roots of the DFS forest are joined to the first one, so
+           the graph is connected;
+        2. two edges next to each other around a vertex that belong to
+           different blocks get their other ends joined, across the face
+           between them, until no vertex separates blocks;
+        3. every face, now a simple cycle, is cut into triangles by ear
+           clipping, skipping the chords that are already edges, and the
+           chords are embedded across it.
+
+        The blocks come from the lowpoints of the first search, and are
+        merged with a union-find over leader as edges are added.
+    */
+    void augment(vector<pair<int, int> >& added)
+    {
+        added.clear();
+        if (V < 3) {
+            // K1 and K2 are the maximal planar graphs on 1 and 2 vertices
+            if (V == 2 && E == 0) {
+                added.push_back(make_pair(0, 1));
+                int h = rotation.add(0, 1);
+                rotation.insertCw(h, -1);
+                rotation.insertCw(h ^ 1, -1);
+            }
+            return;
+        }
+
+        block.assign(E, -1);
+        int blocks = 0;
+        for (int i = 0; i < preorder.size(); i++) {
+            int e = parentEdge[preorder[i]];
+            if (e == -1)
+                continue;
+            int v = tail[e];
+            block[e] = (lowpt[e] >= height[v] ? blocks++ : block[parentEdge[v]]);
+        }
+        for (int e = 0; e < E; e++)
+            if (parentEdge[head[e]] != e)
+                block[e] = block[parentEdge[tail[e]]];
+        leader.resize(blocks + V);
+        for (int b = 0; b < leader.size(); b++)
+            leader[b] = b;
+
+        for (int i = 1; i < roots.size(); i++) {
+            int r = roots[0], s = roots[i];
+            int h = join(r, s, blocks++, added);
+            rotation.insertCw(h, rotation.first[r]);
+            rotation.insertCw(h ^ 1, rotation.first[s]);
+        }
+
+        for (int v = 0; v < V; v++) {
+            int h = rotation.first[v];
+            do {
+                int next = rotation.ccw[h];
+                int a = findBlock(block[h >> 1]), b = findBlock(block[next >> 1]);
+                if (a != b) {
+                    // the face runs u -> v -> w, (w, u) cuts off the corner at v
+                    int u = rotation.target[h], w = rotation.target[next];
+                    leader[a] = b;
+                    int c = join(u, w, b, added);
+                    rotation.insertCw(c, h ^ 1);
+                    rotation.insertCcw(c ^ 1, next ^ 1);
+                }
+                h = next;
+            } while (h != rotation.first[v]);
+        }
+
+        unordered_set<long long> present;
+        present.reserve(3 * V);
+        for (int h = 0; h < rotation.halfEdges(); h += 2)
+            present.insert(edgeKey(rotation.origin(h), rotation.target[h]));
+        // the chords only change the face they cut, so the faces not
+        // walked yet stay as they are
+        vector<char> seen(rotation.halfEdges(), 0);
+        vector<int> face;
+        for (int h = 0; h < seen.size(); h++) {
+            if (seen[h])
+                continue;
+            face.clear();
+            for (int g = h; !seen[g]; g = rotation.nextInFace(g)) {
+                seen[g] = 1;
+                face.push_back(g);
+            }
+            clipEars(face, present, added);
+        }
+    }
+
+    long long edgeKey(int u, int v) const
+    {
+        return (long long)min(u, v) * V + max(u, v);
+    }
+
+    /*
+        clipEars triangulates the face whose boundary is the cycle of
+        half-edges face. It keeps cutting off the corner after a, by the
+        chord from the origin of a to the vertex after next, unless that
+        chord is an edge already; of two consecutive corners at most one
+        has such a chord, as both would run outside the face and cross.
+    */
+    void clipEars(vector<int>& face, unordered_set<long long>& present, vector<pair<int, int> >& added)
+    {
+        int k = face.size();
+        if (k <= 3)
+            return;
+        vector<int> next(k);
+        for (int i = 0; i < k; i++)
+            next[i] = (i + 1) % k;
+        for (int a = 0; k > 3;) {
+            int c = next[next[a]];
+            int x = rotation.origin(face[a]), y = rotation.origin(face[c]);
+            if (present.insert(edgeKey(x, y)).second) {
+                added.push_back(make_pair(min(x, y), max(x, y)));
+                int h = rotation.add(x, y);
+                rotation.insertCw(h, face[a]);
+                rotation.insertCw(h ^ 1, face[c]);
+                // the chord from x takes a's place on what is left
+                face[a] = h;
+                next[a] = c;
+                k--;
+            } else
+                a = next[a];
+        }
+    }
+};
+
+#endif
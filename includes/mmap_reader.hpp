@@ -0,0 +1,548 @@
+/*
+    GraphReader is a drop-in replacement for readGraph. When stdin (or the
+    given descriptor) is a regular file it is memory-mapped, and the rows
+    of a dense matrix are parsed by several threads at once. Pipes and
+    other streams fall back to readGraph.
+
+    Binary graphs (see includes/binary_graph.hpp) are told apart by their
+    first byte and need no parsing: next() lists their edges, and
+    nextView() points a Graph straight at the mapped arrays. A binary
+    stream that cannot be mapped is read into memory first.
+
+    nextMatrix fills a weight matrix instead of an edge list, straight
+    from the rows of a mapped dense matrix.
+
+    Programs including this file must be linked with -pthread.
+*/
+#ifndef MMAP_READER_HPP
+#define MMAP_READER_HPP
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include "binary_graph.hpp"
+#include "graph_io.hpp"
+#include "instrument.hpp"
+
+/*
+    digitRun returns how many of the 8 bytes of chunk, starting from the
+    lowest one, are consecutive ASCII digits.
+*/
+inline int digitRun(unsigned long long chunk)
+{
+    // a byte is a digit iff its high nibble is 3 and adding 6 keeps it 3
+    unsigned long long t = ((chunk & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL)
+        | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL);
+    return t ? (__builtin_ctzll(t) >> 3) : 8;
+}
+
+/*
+    scanInt parses the next integer in [p, end) and moves p past it.
+    Up to eight digits are converted at once with SWAR arithmetic.
+    Returns false if there are no more integers.
+*/
+inline bool scanInt(const char*& p, const char* end, int& n)
+{
+    // the sign is picked up without a branch, the dense matrices
+    // mix 2 and -1 too irregularly for the predictor
+    bool neg = false;
+    while (p < end && (unsigned)(*p - '0') > 9) {
+        neg |= (*p == '-');
+        p++;
+    }
+    if (p == end)
+        return false;
+
+    // single digits, such as the entries of unweighted matrices
+    if (p + 1 == end || (unsigned)(p[1] - '0') > 9) {
+        n = *p++ - '0';
+        n = (neg ? (-n) : (n));
+        return true;
+    }
+
+    n = 0;
+    if (end - p >= 8) {
+        unsigned long long chunk;
+        memcpy(&chunk, p, 8);
+        int d = digitRun(chunk);
+        // keep the d digits in the high bytes, zeros act as leading zeros
+        unsigned long long x = (chunk - 0x3030303030303030ULL) << (8 * (8 - d));
+        x = ((x * 10) + (x >> 8)) & 0x00FF00FF00FF00FFULL;
+        x = ((x * 100) + (x >> 16)) & 0x0000FFFF0000FFFFULL;
+        x = ((x * 10000) + (x >> 32)) & 0x00000000FFFFFFFFULL;
+        n = (int)x;
+        p += d;
+        if (d < 8) {
+            n = (neg ? (-n) : (n));
+            return true;
+        }
+    }
+    while (p < end && '0' <= *p && *p <= '9')
+        n = n * 10 + (*p++ - '0');
+    n = (neg ? (-n) : (n));
+    return true;
+}
+
+/*
+    scanLine reads the integers of the next non-empty line in [p, end)
+    into vals and moves p to the start of the following line.
+*/
+inline int scanLine(const char*& p, const char* end, vector<int>& vals)
+{
+    vals.clear();
+    while (p < end && vals.empty()) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (!eol)
+            eol = end;
+        int n;
+        while (scanInt(p, eol, n))
+            vals.push_back(n);
+        p = (eol < end ? eol + 1 : end);
+    }
+    return vals.empty() ? -1 : vals.size();
+}
+
+/*
+    parseRows parses the dense rows [first, last) whose lines start at
+    line[first], ..., line[last] and appends their edges. Returns false
+    if a row does not hold exactly the expected number of integers.
+*/
+inline bool parseRows(int V, int first, int last, const vector<const char*>& line,
+    vector<pair<int, int> >& edges, vector<int>& weights)
+{
+    for (int i = first; i < last; i++) {
+        const char* p = line[i];
+        int j = i + 1, w;
+        while (scanInt(p, line[i + 1], w)) {
+            if (j >= V)
+                return false;
+            if (w != -1) {
+                edges.push_back(make_pair(i, j));
+                weights.push_back(w);
+            }
+            j++;
+        }
+        if (j != V)
+            return false;
+    }
+    return true;
+}
+
+/*
+    fillRows is parseRows for a weight matrix: it sets the pairs of the
+    rows [first, last) in matrix, and sets wide if a weight does not fit
+    in 16 bits. Rows own distinct pairs, so chunks can fill one matrix
+    at once.
+*/
+template <class Matrix>
+bool fillRows(int V, int first, int last, const vector<const char*>& line, Matrix& matrix, bool& wide)
+{
+    for (int i = first; i < last; i++) {
+        const char* p = line[i];
+        int j = i + 1, w;
+        while (scanInt(p, line[i + 1], w)) {
+            if (j >= V)
+                return false;
+            if (w < SHRT_MIN || w > SHRT_MAX)
+                wide = true;
+            matrix.set(i, j, w);
+            j++;
+        }
+        if (j != V)
+            return false;
+    }
+    return true;
+}
+
+/*
+    listFiles fills files with the sorted names of the regular files
+    in dir and, when recursive, of those below its subdirectories as
+    paths relative to dir. Links to directories are not followed.
+    Returns false if dir cannot be read.
+*/
+inline bool listFiles(const char* dir, vector<string>& files, bool recursive = false)
+{
+    DIR* d = opendir(dir);
+    if (!d)
+        return false;
+    vector<string> subdirs;
+    struct dirent* entry;
+    while ((entry = readdir(d))) {
+        string name = entry->d_name;
+        string path = string(dir) + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            files.push_back(name);
+        else if (recursive && name != "." && name != ".."
+            && lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+            subdirs.push_back(name);
+    }
+    closedir(d);
+    for (int i = 0; i < subdirs.size(); i++) {
+        vector<string> inner;
+        if (listFiles((string(dir) + "/" + subdirs[i]).c_str(), inner, true))
+            for (int j = 0; j < inner.size(); j++)
+                files.push_back(subdirs[i] + "/" + inner[j]);
+    }
+    sort(files.begin(), files.end());
+    return true;
+}
+
+struct GraphReader {
+    const char* data;
+    size_t size, pos;
+    // mapped -> data holds the input, owned -> in copy rather than mmap
+    bool mapped, owned;
+    vector<char> copy;
+    int maxThreads;
+
+    GraphReader()
+    {
+        data = NULL;
+        size = pos = 0;
+        mapped = owned = false;
+        maxThreads = max(1, (int)thread::hardware_concurrency());
+    }
+
+    ~GraphReader()
+    {
+        close();
+    }
+
+    void close()
+    {
+        if (mapped && !owned)
+            munmap((void*)data, size);
+        vector<char>().swap(copy);
+        data = NULL;
+        size = pos = 0;
+        mapped = owned = false;
+    }
+
+    /*
+        open maps the file behind fd. It returns false, leaving the reader
+        on the readGraph fallback, if fd is not a regular file.
+    */
+    bool open(int fd)
+    {
+        close();
+        struct stat st;
+        if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0)
+            return false;
+        void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (addr == MAP_FAILED)
+            return false;
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        data = (const char*)addr;
+        size = st.st_size;
+        pos = 0;
+        mapped = true;
+        return true;
+    }
+
+    /*
+        binary checks if the following graph is a binary one. When stdin
+        is not mapped and starts a binary graph, the whole stream is read
+        in, so that the graphs in it can be viewed.
+    */
+    bool binary()
+    {
+        if (!mapped) {
+            int c = getchar_unlocked();
+            if (c == EOF)
+                return false;
+            ungetc(c, stdin);
+            if (c != (unsigned char)BINARY_MAGIC[0])
+                return false;
+            char chunk[1 << 16];
+            size_t n;
+            while ((n = fread(chunk, 1, sizeof(chunk), stdin)) > 0)
+                copy.insert(copy.end(), chunk, chunk + n);
+            data = copy.data();
+            size = copy.size();
+            pos = 0;
+            mapped = owned = true;
+        }
+        return isBinaryGraph(data + pos, size - pos);
+    }
+
+    /*
+        nextView points graph at the following graph, which must be a
+        binary one, and weights at its weights or NULL. The arrays stay
+        valid until the reader is closed. Returns false if the input is
+        exhausted or the graph is not valid.
+    */
+    bool nextView(Graph& graph, const int*& weights)
+    {
+        Probe probe(PROBE_PARSE);
+        if (!binary())
+            return false;
+        size_t n = viewBinaryGraph(data + pos, size - pos, graph, weights);
+        if (!n)
+            return false;
+        pos += n;
+        return true;
+    }
+
+    /*
+        next reads the following graph, with the same contract as readGraph.
+    */
+    bool next(InputFormat format, int& V, vector<pair<int, int> >& edges, vector<int>& weights)
+    {
+        if (binary()) {
+            Graph view;
+            const int* w;
+            if (!nextView(view, w))
+                return false;
+            V = view.V;
+            binaryEdges(view, w, edges, weights);
+            return true;
+        }
+
+        Probe probe(PROBE_PARSE);
+        if (!mapped)
+            return readGraph(format, V, edges, weights);
+
+        const char *p = data + pos, *end = data + size;
+        vector<int> header;
+        edges.clear();
+        weights.clear();
+        if (scanLine(p, end, header) == -1)
+            return false;
+
+        V = header[0];
+        if (V < 0)
+            return false;
+        if (format == INPUT_AUTO)
+            format = (header.size() >= 2 ? INPUT_EDGES : INPUT_DENSE);
+
+        if (format == INPUT_DENSE && header.size() > 1) {
+            // the matrix starts on the header line, so rows are not lines
+            p = data + pos;
+            scanInt(p, end, V);
+            parseTokens(p, end, V, edges, weights);
+        } else if (format == INPUT_DENSE)
+            parseDense(p, end, V, edges, weights);
+        else {
+            int E = header.size() >= 2 ? header[1] : 0;
+            if (E < 0)
+                return false;
+            parseEdges(p, end, V, E, edges, weights);
+        }
+        pos = p - data;
+        return true;
+    }
+
+    /*
+        nextMatrix reads the following graph into matrix, which has the
+        reset(), set() and build() of Weights (see includes/tmfg.hpp). A
+        mapped dense matrix is parsed straight into it, without the edge
+        list next() would make, which is several times larger than the
+        matrix; anything else goes through next().
+    */
+    template <class Matrix>
+    bool nextMatrix(InputFormat format, int& V, Matrix& matrix)
+    {
+        if (mapped && !binary()) {
+            Probe probe(PROBE_PARSE);
+            const char *p = data + pos, *end = data + size;
+            vector<int> header;
+            if (scanLine(p, end, header) == 1 && header[0] >= 0 && format != INPUT_EDGES
+                && fillDense(p, end, header[0], matrix)) {
+                V = header[0];
+                pos = p - data;
+                return true;
+            }
+        }
+        vector<pair<int, int> > edges;
+        vector<int> weights;
+        if (!next(format, V, edges, weights))
+            return false;
+        matrix.build(V, edges, weights);
+        return true;
+    }
+
+    /*
+        parseDense splits the V - 1 rows at their line breaks into chunks of
+        similar size and parses the chunks in parallel. If the rows are not
+        laid out one per line, it falls back to a sequential scan.
+    */
+    void parseDense(const char*& p, const char* end, int V,
+        vector<pair<int, int> >& edges, vector<int>& weights)
+    {
+        vector<const char*> line;
+        vector<int> first;
+        const char* q = splitRows(p, end, V, line, first);
+        int threads = first.size() - 1;
+        vector<vector<pair<int, int> > > part(threads);
+        vector<vector<int> > partWeights(threads);
+        vector<char> ok(threads, 1);
+
+        vector<thread> pool;
+        for (int t = 1; t < threads; t++)
+            pool.push_back(thread(parseChunk, V, first[t], first[t + 1], cref(line),
+                ref(part[t]), ref(partWeights[t]), &ok[t]));
+        parseChunk(V, first[0], first[1], line, edges, weights, &ok[0]);
+        for (int t = 0; t < pool.size(); t++)
+            pool[t].join();
+
+        bool good = true;
+        for (int t = 0; t < threads; t++)
+            good = good && ok[t];
+        if (!good) {
+            edges.clear();
+            weights.clear();
+            parseTokens(p, end, V, edges, weights);
+            return;
+        }
+        for (int t = 1; t < threads; t++) {
+            edges.insert(edges.end(), part[t].begin(), part[t].end());
+            weights.insert(weights.end(), partWeights[t].begin(), partWeights[t].end());
+        }
+        p = q;
+    }
+
+    /*
+        fillDense parses the V - 1 rows into matrix the way parseDense
+        does, 16 bits wide unless a weight needs more, in which case the
+        rows are parsed again into a wide matrix. Returns false, with p
+        left alone, if the rows are not laid out one per line.
+    */
+    template <class Matrix>
+    bool fillDense(const char*& p, const char* end, int V, Matrix& matrix)
+    {
+        vector<const char*> line;
+        vector<int> first;
+        const char* q = splitRows(p, end, V, line, first);
+        int threads = first.size() - 1;
+        for (int pass = 0; pass < 2; pass++) {
+            matrix.reset(V, pass == 1);
+            vector<char> ok(threads, 1), wide(threads, 0);
+            vector<thread> pool;
+            for (int t = 1; t < threads; t++)
+                pool.push_back(thread(fillChunk<Matrix>, V, first[t], first[t + 1], cref(line),
+                    ref(matrix), &ok[t], &wide[t]));
+            fillChunk(V, first[0], first[1], line, matrix, &ok[0], &wide[0]);
+            for (int t = 0; t < pool.size(); t++)
+                pool[t].join();
+
+            bool good = true, needWide = false;
+            for (int t = 0; t < threads; t++) {
+                good = good && ok[t];
+                needWide = needWide || wide[t];
+            }
+            if (!good)
+                return false;
+            if (!needWide)
+                break;
+        }
+        p = q;
+        return true;
+    }
+
+    template <class Matrix>
+    static void fillChunk(int V, int first, int last, const vector<const char*>& line,
+        Matrix& matrix, char* ok, char* wide)
+    {
+        bool w = false;
+        *ok = fillRows(V, first, last, line, matrix, w);
+        *wide = w;
+    }
+
+    /*
+        splitRows finds where each of the V - 1 rows from p starts, in
+        line, and splits them into chunks [first[t], first[t + 1]) to be
+        parsed by one thread each. Returns the end of the last row.
+    */
+    const char* splitRows(const char* p, const char* end, int V,
+        vector<const char*>& line, vector<int>& first)
+    {
+        int rows = max(V - 1, 0);
+        line.resize(rows + 1);
+        const char* q = p;
+        for (int i = 0; i < rows; i++) {
+            // skip blank lines before a row
+            while (q < end && (*q == '\n' || *q == '\r'))
+                q++;
+            line[i] = q;
+            const char* eol = (const char*)memchr(q, '\n', end - q);
+            q = (eol ? eol + 1 : end);
+        }
+        line[rows] = q;
+
+        // small matrices are not worth starting threads for
+        int threads = (q - p < (1 << 20) ? 1 : maxThreads);
+        first.assign(threads + 1, rows);
+
+        // balance the chunks by bytes, since rows get shorter
+        first[0] = 0;
+        for (int t = 1, i = 0; t < threads; t++) {
+            const char* target = p + (q - p) * t / threads;
+            while (i < rows && line[i] < target)
+                i++;
+            first[t] = i;
+        }
+        return q;
+    }
+
+    static void parseChunk(int V, int first, int last, const vector<const char*>& line,
+        vector<pair<int, int> >& edges, vector<int>& weights, char* ok)
+    {
+        *ok = parseRows(V, first, last, line, edges, weights);
+    }
+
+    /*
+        parseTokens reads the dense matrix ignoring its line layout.
+    */
+    void parseTokens(const char*& p, const char* end, int V,
+        vector<pair<int, int> >& edges, vector<int>& weights)
+    {
+        int w;
+        for (int i = 0; i < V - 1; i++) {
+            for (int j = i + 1; j < V; j++) {
+                if (!scanInt(p, end, w))
+                    return;
+                if (w == -1)
+                    continue;
+                edges.push_back(make_pair(i, j));
+                weights.push_back(w);
+            }
+        }
+        // leave p at the start of the next line
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        p = (eol ? eol + 1 : end);
+    }
+
+    void parseEdges(const char*& p, const char* end, int V, int E,
+        vector<pair<int, int> >& edges, vector<int>& weights)
+    {
+        vector<int> first;
+        if (E == 0 || scanLine(p, end, first) < 2)
+            return;
+        bool weighted = first.size() >= 3;
+        int u = first[0], v = first[1], w = (weighted ? first[2] : 1);
+        edges.reserve(E);
+        weights.reserve(E);
+        for (int i = 0; i < E; i++) {
+            if (i > 0 && !(scanInt(p, end, u) && scanInt(p, end, v) && (!weighted || scanInt(p, end, w))))
+                break;
+            if (u == v || u < 0 || v < 0 || u >= V || v >= V)
+                continue;
+            edges.push_back(make_pair(min(u, v), max(u, v)));
+            weights.push_back(w);
+        }
+        if (E == 1)
+            return;
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        p = (eol ? eol + 1 : end);
+    }
+};
+
+#endif
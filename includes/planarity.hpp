@@ -0,0 +1,567 @@
+/*
+    A fast implementation of Nagamochi et al (2004) planarity test algorithm.
+    The algorithm tests ONLY whether a graph is maximal planar or not.
+
+    PlanarityTester owns every buffer the test needs, so any number of
+    testers may run at the same time on different threads. A tester
+    given more than one thread tries the candidate triangles on its own
+    pool, so programs including this file must be linked with -pthread.
+
+        PlanarityTester tester;
+        bool yes = tester.isMaximalPlanar(graph);
+
+    Given an Embedding, a YES instance also gets its combinatorial
+    embedding, assembled along the insertions of the test. Given a
+    Witness, a NO instance gets the reason it was rejected for.
+*/
+#ifndef PLANARITY_HPP
+#define PLANARITY_HPP
+
+#include <atomic>
+
+#include "csr_graph.hpp"
+#include "first_triangle.hpp"
+#include "instrument.hpp"
+#include "thread_pool.hpp"
+
+/*
+    Embedding is a planar embedding of a maximal planar graph in flat
+    arrays. The neighbours of v in clockwise order are rotation[offset[v]],
+    ..., rotation[offset[v + 1] - 1], and faces holds the 2V - 4 triangles
+    as consecutive triples. Every face is listed with the face on its
+    left, so the inner faces run counter-clockwise; the last one is the
+    outer face, which thus runs clockwise.
+*/
+struct Embedding {
+    int V;
+    vector<int> offset, rotation, faces;
+
+    Embedding()
+    {
+        V = 0;
+    }
+
+    int degree(int v) const
+    {
+        return offset[v + 1] - offset[v];
+    }
+
+    const int* around(int v) const
+    {
+        return &rotation[offset[v]];
+    }
+
+    int faceCount() const
+    {
+        return faces.size() / 3;
+    }
+
+    const int* face(int f) const
+    {
+        return &faces[3 * f];
+    }
+};
+
+/*
+    Witness tells why a graph was rejected, from what the test saw when
+    it gave up:
+
+    WITNESS_EDGE_COUNT -> E != 3V - 6
+    WITNESS_MIN_DEGREE -> no vertex has degree <= 5, or vertex, the
+                          first that does, has degree < 3
+    WITNESS_TRIANGLE   -> v1, v2 and none of the candidates vn form a
+                          triangle (triangle[2] is -1)
+    WITNESS_ORDER      -> order() found no vertex with exactly two
+                          neighbours on the outer boundary to put at
+                          position step of the order
+    WITNESS_INTERVAL   -> the neighbours of vertex already embedded, in
+                          neighbours, are not consecutive on the outer
+                          path; vertex is the step-th of the order
+    WITNESS_DEGREE     -> vertex has degree < 3 or > V - 1
+    WITNESS_CLOSURE    -> some of the neighbours of vertex, in
+                          neighbours, is adjacent to fewer than two of
+                          the others
+
+    The last two come from the prefilter (see includes/prefilter.hpp).
+
+    When several triangles are tried, the witness is the one of the last.
+*/
+enum Reason {
+    WITNESS_NONE,
+    WITNESS_EDGE_COUNT,
+    WITNESS_MIN_DEGREE,
+    WITNESS_TRIANGLE,
+    WITNESS_ORDER,
+    WITNESS_INTERVAL,
+    WITNESS_DEGREE,
+    WITNESS_CLOSURE
+};
+
+static const char* const reasonNames[] = {
+    "none", "edge_count", "min_degree", "triangle", "order", "interval", "degree", "closure"
+};
+
+struct Witness {
+    Reason reason;
+    int step, vertex;
+    int triangle[3];
+    vector<int> neighbours;
+
+    Witness()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        reason = WITNESS_NONE;
+        step = vertex = -1;
+        triangle[0] = triangle[1] = triangle[2] = -1;
+        neighbours.clear();
+    }
+};
+
+class PlanarityTester {
+public:
+    /*
+        threads > 1 tries the candidate triangles of each test
+        concurrently on a pool owned by the tester.
+    */
+    PlanarityTester(int threads = 1)
+    {
+        graph = NULL;
+        V = E = 0;
+        // v1 has degree <= 5, so there are never more than 3 triangles to try
+        threads = max(1, min(threads, 3));
+        pool = (threads > 1 ? new ThreadPool(threads) : NULL);
+        work.resize(threads);
+    }
+
+    ~PlanarityTester()
+    {
+        delete pool;
+    }
+
+    /*
+        isMaximalPlanar tests g and, when it is maximal planar and
+        embedding is not NULL, stores its embedding there. When it is not
+        and witness is not NULL, the reason goes there.
+    */
+    bool isMaximalPlanar(const Graph& g, Embedding* embedding = NULL, Witness* witness = NULL)
+    {
+        graph = &g;
+        V = g.V;
+        E = g.E;
+        rotating = (embedding != NULL);
+        for (int t = 0; t < work.size(); t++)
+            work[t].reserve(V);
+        failure.clear();
+        int t = recognize();
+        if (t != -1 && rotating) {
+            embedding->V = V;
+            embedding->offset.assign(g.offset, g.offset + V + 1);
+            embedding->rotation.swap(work[t].rotation);
+            embedding->faces.swap(work[t].faces);
+        }
+        if (t == -1 && witness)
+            *witness = failure;
+        graph = NULL;
+        return t != -1;
+    }
+
+private:
+    /*
+        Workspace keeps the buffers of order() and embed() alive between
+        graphs. Buffers only grow, and each graph initializes just its
+        first V entries, so a tester never pays for a larger graph seen
+        before. Every thread searching for an embedding owns one.
+
+        vertex_map -> position of each vertex in the order being embedded
+        cancel     -> when set, order() and embed() give up as soon as
+                      another thread has found an embedding
+
+        front, back, rotation and faces only serve the embedding, see
+        rotate(), and are sized for each graph when one is asked for.
+        failure -> why the last triangle tried was rejected
+    */
+    struct Workspace {
+        vector<int> state, cnt, ready;
+        vector<int> prv, nxt, mark, tmp;
+        vector<int> vertex_map;
+        vector<int> front, back, rotation, faces;
+        Witness failure;
+        atomic<bool>* cancel;
+
+        Workspace()
+        {
+            cancel = NULL;
+        }
+
+        void reserve(int n)
+        {
+            if (state.size() >= n)
+                return;
+            state.resize(n);
+            cnt.resize(n);
+            prv.resize(n);
+            nxt.resize(n);
+            mark.resize(n);
+            vertex_map.resize(n);
+        }
+
+        bool cancelled() const
+        {
+            return cancel && cancel->load(memory_order_relaxed);
+        }
+    };
+
+    /*
+        V        -> number of vertices
+        E        -> number of edges
+        rotating -> whether the embedding is assembled as well
+        failure  -> why the graph was rejected
+    */
+    const Graph* graph;
+    int V, E;
+    bool rotating;
+    Witness failure;
+    vector<Workspace> work;
+    ThreadPool* pool;
+
+    // testers own a pool and cannot be copied
+    PlanarityTester(const PlanarityTester&);
+    PlanarityTester& operator=(const PlanarityTester&);
+
+    /*
+        joinOuter puts u on the outer boundary VC and updates the number of
+        VC neighbours of u and of every neighbour of u already on VC.
+    */
+    void joinOuter(int u, vector<int>& state, vector<int>& cnt, vector<int>& ready)
+    {
+        state[u] = 1;
+        for (int i = graph->offset[u]; i < graph->offset[u + 1]; i++) {
+            int w = graph->adj[i];
+            if (state[w] != 1)
+                continue;
+            cnt[u]++;
+            if (++cnt[w] == 2)
+                ready.push_back(w);
+        }
+        if (cnt[u] == 2)
+            ready.push_back(u);
+    }
+
+    /*
+        order returns a canonical order of V(G) of three given vertices.
+
+        Vertices are peeled off the outer boundary VC from the last to the
+        first position. cnt[u] keeps how many neighbours of u lie on VC, so a
+        vertex can be removed exactly when cnt drops to 2 (it has no chord).
+        Removing a vertex only touches its own neighbours, which makes the
+        whole ordering O(V + E).
+    */
+    vector<int> order(Workspace& work, int v1, int v2, int vn)
+    {
+        Probe probe(PROBE_ORDER);
+        // vi -> vector with the output order of vertices
+        vector<int> vi(V);
+        vi[0] = v1;
+        vi[1] = v2;
+
+        // state -> 0: not reached yet, 1: on VC, 2: removed
+        // cnt   -> number of neighbours which are on VC
+        // ready -> candidates for removal, validated when popped
+        vector<int>& state = work.state;
+        vector<int>& cnt = work.cnt;
+        vector<int>& ready = work.ready;
+        fill(state.begin(), state.begin() + V, 0);
+        fill(cnt.begin(), cnt.begin() + V, 0);
+        ready.clear();
+
+        joinOuter(v1, state, cnt, ready);
+        joinOuter(v2, state, cnt, ready);
+        joinOuter(vn, state, cnt, ready);
+
+        for (int pos = V - 1; pos > 1; pos--) {
+            // choose a vertex v belonging to VC which is neither v1 nor v2
+            // and which has exactly two neighbours on VC.
+            int v = -1;
+            while (!ready.empty()) {
+                int u = ready.back();
+                ready.pop_back();
+                if (state[u] == 1 && cnt[u] == 2 && u != v1 && u != v2) {
+                    v = u;
+                    break;
+                }
+            }
+            // if such vertex does not exist, halt.
+            if (v == -1 || work.cancelled()) {
+                work.failure.reason = WITNESS_ORDER;
+                work.failure.step = pos;
+                return vector<int>();
+            }
+
+            // otherwise, remove this vertex from VC
+            state[v] = 2;
+            for (int i = graph->offset[v]; i < graph->offset[v + 1]; i++) {
+                int w = graph->adj[i];
+                if (state[w] == 1 && --cnt[w] == 2)
+                    ready.push_back(w);
+            }
+
+            // and join VC with the chosen vertex's neighbours.
+            for (int i = graph->offset[v]; i < graph->offset[v + 1]; i++) {
+                int w = graph->adj[i];
+                if (state[w] == 0)
+                    joinOuter(w, state, cnt, ready);
+            }
+
+            // add the chosen vertex to the answer
+            vi[pos] = v;
+        }
+
+        return vi;
+    }
+
+    /*
+        areConsecutive checks if the vertices of tmp appear consecutively
+        on the outer path. On success, lb and hb receive the leftmost and
+        the rightmost vertices of that interval.
+    */
+    bool areConsecutive(vector<int>& tmp, vector<int>& prv, vector<int>& nxt, vector<int>& mark, int stamp, int& lb, int& hb)
+    {
+        int t = tmp.size(), left = 0, right = 0;
+        if (t < 2)
+            return false;
+        for (int i = 0; i < t; i++) {
+            if (mark[tmp[i]] < 0)
+                return false;
+            mark[tmp[i]] = stamp;
+        }
+
+        // every maximal run of marked vertices has exactly one leftmost
+        // and one rightmost element, so a single run means consecutive.
+        for (int i = 0; i < t; i++) {
+            int u = tmp[i];
+            if (prv[u] == -1 || mark[prv[u]] != stamp) {
+                lb = u;
+                left++;
+            }
+            if (nxt[u] == -1 || mark[nxt[u]] != stamp) {
+                hb = u;
+                right++;
+            }
+        }
+        return left == 1 && right == 1;
+    }
+
+    /*
+        embed checks if the graph has a planar embedding.
+
+        The outer cycle is kept as a doubly linked path from pi[0] to pi[1]
+        (the edge pi[0]pi[1] closes it), so each vertex is checked and
+        spliced in time proportional to its degree. work.vertex_map must
+        hold the position of every vertex in pi.
+    */
+    vector<int> embed(Workspace& work, vector<int>& pi)
+    {
+        Probe probe(PROBE_EMBED);
+        // prv, nxt -> neighbours on the outer path, -1 past its ends
+        // mark     -> -1 if a vertex is not on the outer path, otherwise
+        //             the last insertion step that looked at it
+        vector<int>& prv = work.prv;
+        vector<int>& nxt = work.nxt;
+        vector<int>& mark = work.mark;
+        vector<int>& tmp = work.tmp;
+        vector<int>& vertex_map = work.vertex_map;
+        fill(prv.begin(), prv.begin() + V, -1);
+        fill(nxt.begin(), nxt.begin() + V, -1);
+        fill(mark.begin(), mark.begin() + V, -1);
+        // the path starts as the edge pi[0]pi[1], and pi[2] goes on it
+        // like any other vertex
+        nxt[pi[0]] = pi[1];
+        prv[pi[1]] = pi[0];
+        mark[pi[0]] = mark[pi[1]] = 0;
+        if (rotating)
+            startRotation(work, pi[0], pi[1]);
+
+        for (int i = 2; i < V; i++) {
+            int w = pi[i];
+            // sublist {u_p, u_p+1, ..., u_p+n} = {v1, ..., v_i-1} inter NG(vi)
+            tmp.clear();
+            for (int k = graph->offset[w]; k < graph->offset[w + 1]; k++)
+                if (vertex_map[graph->adj[k]] < i)
+                    tmp.push_back(graph->adj[k]);
+
+            int lb = -1, hb = -1;
+            if (!areConsecutive(tmp, prv, nxt, mark, i, lb, hb) || work.cancelled()) {
+                work.failure.reason = WITNESS_INTERVAL;
+                work.failure.step = i;
+                work.failure.vertex = w;
+                work.failure.neighbours = tmp;
+                return vector<int>();
+            }
+            if (rotating)
+                rotate(work, w, lb, hb, tmp.size());
+
+            // the inner vertices of the interval leave the outer path
+            for (int k = 0; k < tmp.size(); k++)
+                if (tmp[k] != lb && tmp[k] != hb)
+                    mark[tmp[k]] = -1;
+
+            nxt[lb] = w;
+            prv[w] = lb;
+            nxt[w] = hb;
+            prv[hb] = w;
+            mark[w] = i;
+        }
+
+        vector<int> VC;
+        for (int u = pi[0]; u != -1; u = nxt[u])
+            VC.push_back(u);
+        if (rotating)
+            work.faces.insert(work.faces.end(), VC.begin(), VC.end());
+        return VC;
+    }
+
+    /*
+        startRotation prepares the embedding of the base edge ab, a on
+        the left end of the outer path and b on the right one.
+
+        The rotation of a vertex v is filled in three parts. Its t lower
+        neighbours, taken when v is inserted, go first as u_t, ..., u_1.
+        Every later vertex attached to v while v is the right end of its
+        interval comes next, from the front, and every one attached while
+        v is the left end fills the slots from the back. The vertex that
+        finally covers v goes in the single slot left between them.
+    */
+    void startRotation(Workspace& work, int a, int b)
+    {
+        work.front.resize(V);
+        work.back.resize(V);
+        work.rotation.resize(2 * E);
+        work.faces.clear();
+        work.faces.reserve(3 * (2 * V - 4));
+        for (int v = 0; v < V; v++) {
+            work.front[v] = graph->offset[v];
+            work.back[v] = graph->offset[v + 1] - 1;
+        }
+        work.rotation[work.front[a]++] = b;
+        work.rotation[work.front[b]++] = a;
+    }
+
+    /*
+        rotate adds w, whose t lower neighbours form the interval from
+        lb to hb of the outer path, to the embedding: the rotations of w
+        and its lower neighbours, and the t - 1 faces below w.
+    */
+    void rotate(Workspace& work, int w, int lb, int hb, int t)
+    {
+        vector<int>& rotation = work.rotation;
+        vector<int>& faces = work.faces;
+        int slot = graph->offset[w] + t - 1;
+        work.front[w] = slot + 1;
+        for (int u = lb; ; u = work.nxt[u]) {
+            rotation[slot--] = u;
+            // w lies right of lb, left of hb and covers the vertices
+            // between them, which fills their last slot
+            if (u == lb)
+                rotation[work.back[u]--] = w;
+            else
+                rotation[work.front[u]++] = w;
+            if (u == hb)
+                break;
+            faces.push_back(w);
+            faces.push_back(u);
+            faces.push_back(work.nxt[u]);
+        }
+    }
+
+    /*
+        tryTriangle looks for an embedding which starts from the triangle
+        (v1, v2, vn), using the buffers of work.
+    */
+    bool tryTriangle(Workspace& work, int v1, int v2, int vn)
+    {
+        Probe probe(PROBE_TRIANGLE);
+        if (instrument.traced()) {
+            int t[] = {v1, v2, vn};
+            instrument.trace("triangle", t, 3);
+        }
+        work.failure.clear();
+        work.failure.triangle[0] = v1;
+        work.failure.triangle[1] = v2;
+        work.failure.triangle[2] = vn;
+        vector<int> pi = order(work, v1, v2, vn);
+        if (!pi.size())
+            return false;
+
+        if (instrument.traced())
+            instrument.trace("order", &pi[0], pi.size());
+        for (int k = 0; k < pi.size(); k++)
+            work.vertex_map[pi[k]] = k;
+
+        vector<int> ans = embed(work, pi);
+        return ans.size() > 0;
+    }
+
+    /*
+        Recognizes if a given graph is either maximal planar or not.
+        When a thread pool is running, the candidate triangles are tried
+        concurrently and the search stops once one of them is embedded.
+        Returns the workspace holding the embedding, or -1 if there is
+        none.
+    */
+    int recognize()
+    {
+        FirstTriangle start;
+        StartResult started = start.find(*graph);
+        if (started != START_FOUND) {
+            failure.reason = (started == START_EDGE_COUNT ? WITNESS_EDGE_COUNT : WITNESS_MIN_DEGREE);
+            failure.vertex = start.v1;
+            return -1;
+        }
+        int v1 = start.v1, v2 = start.v2;
+        failure.reason = WITNESS_TRIANGLE;
+        failure.triangle[0] = v1;
+        failure.triangle[1] = v2;
+        vector<int> candidates;
+        for (int i = 0; i < start.candidates; i++) {
+            int vn = start.candidate(i);
+            if (vn == -1)
+                continue;
+
+            if (!pool) {
+                if (tryTriangle(work[0], v1, v2, vn))
+                    return 0;
+                failure = work[0].failure;
+            }
+            candidates.push_back(vn);
+        }
+        if (!pool || candidates.empty())
+            return -1;
+
+        // tried -> the witness of every candidate, kept until all failed
+        atomic<int> next(0), winner(-1);
+        atomic<bool> found(false);
+        vector<Witness> tried(candidates.size());
+        pool->run([&](int t) {
+            Workspace& mine = work[t];
+            mine.cancel = &found;
+            for (int k = next++; k < candidates.size() && !found; k = next++)
+                if (tryTriangle(mine, v1, v2, candidates[k])) {
+                    // the first thread to succeed keeps its workspace
+                    int none = -1;
+                    winner.compare_exchange_strong(none, t);
+                    found = true;
+                } else
+                    tried[k] = mine.failure;
+            mine.cancel = NULL;
+        });
+        if (winner == -1)
+            failure = tried.back();
+        return winner;
+    }
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+    Prefilter rejects most graphs that cannot be maximal planar straight
+    from the parsed edge list, before the adjacency is built and sorted
+    and before any ordering starts. Its checks go from cheap to less
+    cheap, every one a single pass:
+
+    1. E == 3V - 6
+    2. the degree histogram: every degree within [3, V - 1]. With the
+       edge count right this also gives the degree sum 6V - 12, which
+       forces at least four vertices of degree <= 5, so it needs no
+       separate test.
+    3. triangle closure around a sample of up to 32 vertices of degree
+       <= 5: in a maximal planar graph the neighbours of a vertex form a
+       cycle, so each of them is adjacent to at least two others.
+
+    A graph passing the filter may still be rejected by the full test,
+    and a maximal planar graph always passes it. Rejections are
+    described by a Witness (see includes/planarity.hpp).
+
+        Prefilter filter;
+        if (!filter.check(V, edges, witness))
+            ...
+*/
+#ifndef PREFILTER_HPP
+#define PREFILTER_HPP
+
+#include <array>
+
+#include "planarity.hpp"
+
+const int PREFILTER_SAMPLES = 32;
+
+struct Prefilter {
+    /*
+        degree   -> degree of every vertex
+        sampleOf -> index of every sampled vertex, -1 for the others
+        mask     -> bit s is set for the neighbours of sample s
+    */
+    vector<int> degree, sampleOf;
+    vector<unsigned> mask;
+
+    /*
+        check tells whether the graph with V vertices and the given edges
+        may be maximal planar. When it cannot, witness says why.
+    */
+    bool check(int V, const vector<pair<int, int> >& edges, Witness& witness)
+    {
+        witness.clear();
+        int E = edges.size();
+        if (E != 3 * V - 6) {
+            witness.reason = WITNESS_EDGE_COUNT;
+            return false;
+        }
+
+        degree.assign(V, 0);
+        for (int i = 0; i < E; i++) {
+            degree[edges[i].first]++;
+            degree[edges[i].second]++;
+        }
+        // samples -> the first vertices of degree <= 5
+        vector<int> samples;
+        for (int v = 0; v < V; v++) {
+            if (degree[v] < 3 || degree[v] > V - 1) {
+                witness.reason = WITNESS_DEGREE;
+                witness.vertex = v;
+                return false;
+            }
+            if (degree[v] <= 5 && samples.size() < PREFILTER_SAMPLES)
+                samples.push_back(v);
+        }
+        return closed(V, edges, samples, witness);
+    }
+
+private:
+    /*
+        closed checks that every neighbour of each sampled vertex is
+        adjacent to two other neighbours of it, in two passes over the
+        edges: one collects the neighbourhoods, the other counts the
+        edges inside them.
+    */
+    bool closed(int V, const vector<pair<int, int> >& edges, const vector<int>& samples, Witness& witness)
+    {
+        int S = samples.size(), E = edges.size();
+        // around[s] -> neighbours of sample s, hits[s] -> their edges
+        //              to the other neighbours of s
+        vector<array<int, 5> > around(S), hits(S);
+        vector<int> found(S, 0);
+        sampleOf.assign(V, -1);
+        for (int s = 0; s < S; s++)
+            sampleOf[samples[s]] = s;
+        for (int i = 0; i < E; i++) {
+            int a = edges[i].first, b = edges[i].second;
+            if (sampleOf[a] != -1)
+                around[sampleOf[a]][found[sampleOf[a]]++] = b;
+            if (sampleOf[b] != -1)
+                around[sampleOf[b]][found[sampleOf[b]]++] = a;
+        }
+
+        mask.assign(V, 0);
+        for (int s = 0; s < S; s++) {
+            hits[s].fill(0);
+            for (int k = 0; k < found[s]; k++)
+                mask[around[s][k]] |= 1u << s;
+        }
+        for (int i = 0; i < E; i++) {
+            int a = edges[i].first, b = edges[i].second;
+            for (unsigned common = mask[a] & mask[b]; common; common &= common - 1) {
+                int s = __builtin_ctz(common);
+                for (int k = 0; k < found[s]; k++)
+                    if (around[s][k] == a || around[s][k] == b)
+                        hits[s][k]++;
+            }
+        }
+
+        for (int s = 0; s < S; s++)
+            for (int k = 0; k < found[s]; k++)
+                if (hits[s][k] < 2) {
+                    witness.reason = WITNESS_CLOSURE;
+                    witness.vertex = samples[s];
+                    witness.neighbours.assign(around[s].begin(), around[s].begin() + found[s]);
+                    return false;
+                }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,259 @@
+/*
+    Recognizer is the set-based version of the Nagamochi et al (2004)
+    maximal planarity test, written once over a set policy (see
+    includes/set_policy.hpp). The membership tests of order(),
+    areConsecutive() and embed() all go through Set, so every policy gets
+    its own fully inlined specialization:
+
+        Recognizer<FlatHashSet> recognizer;
+        bool yes = recognizer.isMaximalPlanar(graph);
+*/
+#ifndef RECOGNIZER_HPP
+#define RECOGNIZER_HPP
+
+#include "csr_graph.hpp"
+#include "first_triangle.hpp"
+#include "instrument.hpp"
+#include "set_policy.hpp"
+
+template <class Set>
+class Recognizer {
+public:
+    Recognizer()
+    {
+        graph = NULL;
+        V = E = 0;
+    }
+
+    bool isMaximalPlanar(const Graph& g)
+    {
+        graph = &g;
+        V = g.V;
+        E = g.E;
+        vertex_map.assign(V, 0);
+        bucket.reset(V);
+        placed.reset(V);
+        removed.reset(V);
+        bool ans = recognize();
+        graph = NULL;
+        return ans;
+    }
+
+private:
+    /*
+        V -> number of vertices
+        E -> number of edges
+
+        vertex_map -> position of each vertex in the order or outer path
+        bucket     -> scratch set for the intersections and unions
+        placed     -> vertices already embedded by embed()
+        removed    -> vertices already taken out of VC by order()
+    */
+    const Graph* graph;
+    int V, E;
+    vector<int> vertex_map;
+    Set bucket, placed, removed;
+
+    // the sets of some policies own memory and cannot be copied
+    Recognizer(const Recognizer&);
+    Recognizer& operator=(const Recognizer&);
+
+    /*
+        order returns a canonical order of V(G) of three given vertices.
+    */
+    vector<int> order(int v1, int v2, int vn)
+    {
+        Probe probe(PROBE_ORDER);
+        vector<int> VC, vi(V);
+        // vi -> vector with the output order of vertices
+        vi[0] = v1;
+        vi[1] = v2;
+        VC.push_back(v1);
+        VC.push_back(v2);
+        VC.push_back(vn);
+
+        // x         -> number of elements in VC
+        // remaining -> vertices but v1 and v2 not yet removed
+        // bucket    -> every vertex which ever joined VC, so a vertex is
+        //              in VC iff it is in bucket and not in removed
+        int x = VC.size(), pos = V - 1, remaining = V - 2;
+        bucket.assign(&VC[0], &VC[0] + x);
+        removed.clear();
+
+        while (remaining > 0) {
+            int v, sz = -1;
+
+            // choose a vertex v belonging to VC which is neither v1 nor v2
+            // and which its neighbours' intersection with VC has size == 2.
+            for (int i = 0; i < x; i++) {
+                if (VC[i] == v1 || VC[i] == v2)
+                    continue;
+                v = VC[i];
+
+                sz = 0;
+                for (int k = graph->offset[v]; k < graph->offset[v + 1]; k++) {
+                    int at = graph->adj[k];
+                    if (bucket.find(at) && !removed.find(at))
+                        sz++;
+                }
+
+                if (sz != 2)
+                    continue;
+                break;
+            }
+            // if such vertex does not exist, halt.
+            if (sz != 2)
+                return vector<int>();
+
+            // otherwise, remove this vertex from VC
+            for (int i = 0; i < x; i++) {
+                if (VC[i] == v) {
+                    swap(VC[i], VC[x - 1]);
+                    VC.pop_back();
+                    break;
+                }
+            }
+
+            remaining--;
+            removed.insert(v);
+
+            // and join VC with the chosen vertex's neighbours.
+            // union
+            for (int k = graph->offset[v]; k < graph->offset[v + 1]; k++) {
+                int at = graph->adj[k];
+                if (!bucket.find(at)) {
+                    bucket.insert(at);
+                    VC.push_back(at);
+                }
+            }
+            x = VC.size();
+
+            // add the chosen vertex to the answer
+            vi[pos] = v;
+            pos--;
+        }
+
+        return vi;
+    }
+
+    /*
+        areConsecutive checks if a set of vertices appear
+        consecutively into another sequence.
+    */
+    bool areConsecutive(vector<int>& tmp, vector<int>& VC)
+    {
+        int sz = VC.size(), t = tmp.size(), k = sz;
+
+        if (t > sz)
+            return false;
+
+        // where is the lower bound occurence of an element on the intersection?
+        bucket.clear();
+        for (int i = 0; i < t; i++) {
+            bucket.insert(tmp[i]);
+            k = min(k, vertex_map[tmp[i]]);
+        }
+
+        if (k + t > sz)
+            return false;
+
+        for (int i = 0; i < t; i++, k++) {
+            if (!bucket.find(VC[k]))
+                return false;
+        }
+        return true;
+    }
+
+    /*
+        embed checks if the graph has a planar embedding.
+    */
+    bool embed(vector<int>& pi)
+    {
+        Probe probe(PROBE_EMBED);
+        vector<int> VC;
+        VC.push_back(pi[0]);
+        VC.push_back(pi[2]);
+        VC.push_back(pi[1]);
+
+        // the placed prefix only grows, so it is kept across iterations
+        placed.assign(&pi[0], &pi[0] + 3);
+
+        for (int i = 3; i < V; i++) {
+            // sublist {u_p, u_p+1, ..., u_p+n} = {v1, ..., v_i-1} inter NG(vi)
+            vector<int> tmp;
+            for (int k = graph->offset[pi[i]]; k < graph->offset[pi[i] + 1]; k++) {
+                int at = graph->adj[k];
+                if (placed.find(at))
+                    tmp.push_back(at);
+            }
+
+            for (int j = 0; j < VC.size(); j++)
+                vertex_map[VC[j]] = j;
+
+            // where is the lower and higher bound occurences of the elements
+            // on the intersection?
+            int lb = VC.size(), hb = -1;
+            for (int k = 0; k < tmp.size(); k++) {
+                lb = min(lb, vertex_map[tmp[k]]);
+                hb = max(hb, vertex_map[tmp[k]]);
+            }
+
+            if (!areConsecutive(tmp, VC))
+                return false;
+
+            vector<int> cons;
+            int k = 0;
+            while (k < lb)
+                cons.push_back(VC[k++]);
+            cons.push_back(VC[lb]);
+            cons.push_back(pi[i]);
+            cons.push_back(VC[hb]);
+            k = hb + 1;
+            while (k < VC.size())
+                cons.push_back(VC[k++]);
+
+            VC.swap(cons);
+            placed.insert(pi[i]);
+        }
+        return true;
+    }
+
+    /*
+        recognize checks if a given graph is either maximal planar or not.
+    */
+    bool recognize()
+    {
+        FirstTriangle start;
+        if (start.find(*graph) != START_FOUND)
+            return false;
+        int v1 = start.v1, v2 = start.v2;
+        for (int i = 0; i < start.candidates; i++) {
+            int vn = start.candidate(i);
+            if (vn == -1)
+                continue;
+
+            Probe probe(PROBE_TRIANGLE);
+            if (instrument.traced()) {
+                int t[] = {v1, v2, vn};
+                instrument.trace("triangle", t, 3);
+            }
+
+            vector<int> pi = order(v1, v2, vn);
+            if (!pi.size())
+                continue;
+
+            if (instrument.traced())
+                instrument.trace("order", &pi[0], V);
+            for (int j = 0; j < V; j++)
+                vertex_map[j] = -1;
+            for (int k = 0; k < V; k++)
+                vertex_map[pi[k]] = k;
+
+            if (embed(pi))
+                return true;
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,203 @@
+/*
+    Set policies for Recognizer (includes/recognizer.hpp). Every policy
+    stores a set of vertices in [0, n) behind the same interface:
+
+        reset(n)            makes room for the vertices [0, n), empty set
+        clear()             empties the set
+        insert(v)           adds v
+        find(v)             whether v is in the set
+        assign(first, last) replaces the set with the range [first, last)
+
+    SortedSet   -> sorted vector and binary search
+    BitsetSet   -> one bit per vertex, see includes/bitset.hpp
+    AvlSet      -> AVL tree over a node pool, see includes/avl.hpp
+    FlatHashSet -> open addressing with linear probing
+*/
+#ifndef SET_POLICY_HPP
+#define SET_POLICY_HPP
+
+#include "avl.hpp"
+#include "bitset.hpp"
+
+struct SortedSet {
+    vector<int> items;
+
+    void reset(int n)
+    {
+        items.clear();
+        items.reserve(n);
+    }
+
+    void clear()
+    {
+        items.clear();
+    }
+
+    void insert(int v)
+    {
+        vector<int>::iterator it = lower_bound(items.begin(), items.end(), v);
+        if (it == items.end() || *it != v)
+            items.insert(it, v);
+    }
+
+    bool find(int v) const
+    {
+        return binary_search(items.begin(), items.end(), v);
+    }
+
+    void assign(const int* first, const int* last)
+    {
+        items.assign(first, last);
+        sort(items.begin(), items.end());
+    }
+};
+
+struct BitsetSet {
+    Bitset bits;
+
+    void reset(int n)
+    {
+        bits.resize(n);
+    }
+
+    void clear()
+    {
+        bits.clear();
+    }
+
+    void insert(int v)
+    {
+        bits.insert(v);
+    }
+
+    bool find(int v) const
+    {
+        return bits.find(v);
+    }
+
+    void assign(const int* first, const int* last)
+    {
+        bits.clear();
+        for (; first != last; first++)
+            bits.insert(*first);
+    }
+};
+
+struct AvlSet {
+    NodePool pool;
+    node* root;
+
+    AvlSet()
+    {
+        root = NULL;
+    }
+
+    void reset(int /* n */)
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        pool.reset();
+        root = NULL;
+    }
+
+    void insert(int v)
+    {
+        root = ::insert(pool, root, v);
+    }
+
+    bool find(int v) const
+    {
+        return ::find(root, v);
+    }
+
+    void assign(const int* first, const int* last)
+    {
+        clear();
+        for (; first != last; first++)
+            root = ::insert(pool, root, *first);
+    }
+};
+
+/*
+    FlatHashSet keeps its keys in a power of two table at least twice
+    as large as n, so probes stay short. A slot belongs to the set only
+    if its stamp is the current one, which makes clear() O(1).
+*/
+struct FlatHashSet {
+    struct Slot {
+        int key;
+        unsigned stamp;
+    };
+
+    vector<Slot> slots;
+    // now -> stamp of the current set, shift -> 32 - log2(table size)
+    unsigned now;
+    int shift;
+
+    FlatHashSet()
+    {
+        now = 1;
+        shift = 32;
+    }
+
+    void reset(int n)
+    {
+        int bits = 4;
+        while ((1 << bits) < 2 * n)
+            bits++;
+        Slot empty = {0, 0};
+        slots.assign(1 << bits, empty);
+        shift = 32 - bits;
+        now = 1;
+    }
+
+    void clear()
+    {
+        if (++now == 0) {
+            for (int i = 0; i < slots.size(); i++)
+                slots[i].stamp = 0;
+            now = 1;
+        }
+    }
+
+    // home is the first slot probed for v, by Fibonacci hashing
+    unsigned home(int v) const
+    {
+        return ((unsigned)v * 2654435769u) >> shift;
+    }
+
+    void insert(int v)
+    {
+        unsigned mask = slots.size() - 1, h = home(v);
+        while (slots[h].stamp == now) {
+            if (slots[h].key == v)
+                return;
+            h = (h + 1) & mask;
+        }
+        slots[h].key = v;
+        slots[h].stamp = now;
+    }
+
+    bool find(int v) const
+    {
+        unsigned mask = slots.size() - 1, h = home(v);
+        while (slots[h].stamp == now) {
+            if (slots[h].key == v)
+                return true;
+            h = (h + 1) & mask;
+        }
+        return false;
+    }
+
+    void assign(const int* first, const int* last)
+    {
+        clear();
+        for (; first != last; first++)
+            insert(*first);
+    }
+};
+
+#endif
@@ -0,0 +1,159 @@
+/*
+    Stats records, for every phase of a run, its wall time, the heap
+    allocations made during it and the peak resident set size at its end.
+    Drivers turn it on with --stats; the phases are then written to stderr
+    as lines of the form
+
+        stats <phase> <seconds> <allocations> <bytes> <peak rss in KB>
+
+    which the benchmark harness collects.
+
+    Allocations are counted by replacing the global operator new, which
+    costs every allocation two atomic additions, so it is only compiled
+    in with -DCOUNT_ALLOCS, as the benchmark builds do; otherwise the
+    allocation columns stay 0. Such a build must include this file from
+    exactly one translation unit.
+*/
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <sys/resource.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+/*
+    allocCount and allocBytes return the number of calls to operator new
+    and the bytes they requested, one counter each for the whole program.
+*/
+inline atomic<long>& allocCount()
+{
+    static atomic<long> count(0);
+    return count;
+}
+
+inline atomic<long>& allocBytes()
+{
+    static atomic<long> bytes(0);
+    return bytes;
+}
+
+#ifdef COUNT_ALLOCS
+void* operator new(size_t size)
+{
+    allocCount().fetch_add(1, memory_order_relaxed);
+    allocBytes().fetch_add(size, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+#endif
+
+/*
+    peakRss returns the peak resident set size of the process in KB.
+*/
+inline long peakRss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+struct Stats {
+    struct Phase {
+        string name;
+        double seconds;
+        long allocs, bytes, rss;
+    };
+
+    bool enabled;
+    vector<Phase> phases;
+    chrono::steady_clock::time_point mark;
+    long allocs, bytes;
+
+    Stats()
+    {
+        enabled = false;
+        start();
+    }
+
+    /*
+        start opens a new phase.
+    */
+    void start()
+    {
+        mark = chrono::steady_clock::now();
+        allocs = allocCount().load(memory_order_relaxed);
+        bytes = allocBytes().load(memory_order_relaxed);
+    }
+
+    /*
+        stop closes the current phase under name and opens the next one.
+    */
+    void stop(const char* name)
+    {
+        if (!enabled)
+            return;
+        Phase p;
+        p.name = name;
+        p.seconds = chrono::duration<double>(chrono::steady_clock::now() - mark).count();
+        p.allocs = allocCount().load(memory_order_relaxed) - allocs;
+        p.bytes = allocBytes().load(memory_order_relaxed) - bytes;
+        p.rss = peakRss();
+        phases.push_back(p);
+        start();
+    }
+
+    /*
+        report writes the phases and the answer of the run to stderr.
+    */
+    void report(bool answer)
+    {
+        if (!enabled)
+            return;
+        for (int i = 0; i < phases.size(); i++)
+            fprintf(stderr, "stats %s %.9f %ld %ld %ld\n", phases[i].name.c_str(),
+                phases[i].seconds, phases[i].allocs, phases[i].bytes, phases[i].rss);
+        fprintf(stderr, "stats answer %s\n", answer ? "YES" : "NO");
+    }
+};
+
+/*
+    parseStats returns whether the command line asks for --stats.
+*/
+inline bool parseStats(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+        if (string(argv[i]) == "--stats")
+            return true;
+    return false;
+}
+
+#endif
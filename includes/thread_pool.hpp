@@ -0,0 +1,142 @@
+/*
+    ThreadPool keeps n - 1 threads waiting for jobs. run(job) calls
+    job(0) on the calling thread and job(1), ..., job(n - 1) on the pool,
+    and returns once all of them are done.
+
+    Channel hands items from the threads of one stage to those of the
+    next. push() waits while the channel is full, so a fast stage never
+    runs more than capacity items ahead of a slow one.
+
+    Programs including this file must be linked with -pthread.
+*/
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+struct ThreadPool {
+    vector<thread> threads;
+    mutex lock;
+    condition_variable wake, done;
+    function<void(int)> job;
+    int generation, running;
+    bool quit;
+
+    ThreadPool(int n)
+    {
+        generation = running = 0;
+        quit = false;
+        for (int i = 1; i < n; i++)
+            threads.push_back(thread(&ThreadPool::loop, this, i));
+    }
+
+    ~ThreadPool()
+    {
+        {
+            unique_lock<mutex> guard(lock);
+            quit = true;
+        }
+        wake.notify_all();
+        for (int i = 0; i < threads.size(); i++)
+            threads[i].join();
+    }
+
+    int size() const
+    {
+        return threads.size() + 1;
+    }
+
+    void run(const function<void(int)>& f)
+    {
+        {
+            unique_lock<mutex> guard(lock);
+            job = f;
+            running = threads.size();
+            generation++;
+        }
+        wake.notify_all();
+        f(0);
+
+        unique_lock<mutex> guard(lock);
+        while (running > 0)
+            done.wait(guard);
+    }
+
+    void loop(int id)
+    {
+        int seen = 0;
+        while (true) {
+            function<void(int)> f;
+            {
+                unique_lock<mutex> guard(lock);
+                while (!quit && generation == seen)
+                    wake.wait(guard);
+                if (quit)
+                    return;
+                seen = generation;
+                f = job;
+            }
+            f(id);
+            unique_lock<mutex> guard(lock);
+            if (--running == 0)
+                done.notify_one();
+        }
+    }
+};
+
+template <class T>
+struct Channel {
+    deque<T> items;
+    size_t capacity;
+    bool closed;
+    mutex lock;
+    condition_variable changed;
+
+    Channel(size_t n)
+    {
+        capacity = max(n, (size_t)1);
+        closed = false;
+    }
+
+    void push(const T& item)
+    {
+        unique_lock<mutex> guard(lock);
+        while (items.size() >= capacity)
+            changed.wait(guard);
+        items.push_back(item);
+        changed.notify_all();
+    }
+
+    /*
+        pop takes the oldest item into item. Returns false once the
+        channel is closed and empty.
+    */
+    bool pop(T& item)
+    {
+        unique_lock<mutex> guard(lock);
+        while (items.empty() && !closed)
+            changed.wait(guard);
+        if (items.empty())
+            return false;
+        item = items.front();
+        items.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+    /*
+        close tells the readers that nothing more will be pushed.
+    */
+    void close()
+    {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        changed.notify_all();
+    }
+};
+
+#endif
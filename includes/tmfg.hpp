@@ -0,0 +1,471 @@
+/*
+    Triangulated maximally filtered graph (TMFG) construction.
+
+    Weights holds the input, shared read-only by any number of
+    TmfgBuilders. A builder owns all the state of one construction (face
+    list, remaining vertices, output edges), so builders for different
+    seeds may run at the same time on different threads:
+
+        TmfgBuilder builder(weights);
+        int seed[4] = {0, 1, 2, 3};
+        int total = builder.build(seed);
+        // builder.edges() holds the 3V - 6 edges of the planar graph
+
+    searchSeeds runs one builder per thread over a list of seeds and
+    keeps the heaviest graph, so programs including this file must be
+    linked with -pthread. A seed is four distinct vertices, which graphs
+    with fewer than 4 have not: callers skip those.
+*/
+#ifndef TMFG_HPP
+#define TMFG_HPP
+
+#include <array>
+#include <atomic>
+#include <climits>
+#include <queue>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TMFG_X86
+#endif
+
+#include "thread_pool.hpp"
+
+/*
+    Weights holds the weights of the complete graph on n vertices as a
+    symmetric row-major matrix, so that the weights from a vertex to all
+    the others are contiguous. Pairs missing from the input weigh -1.
+
+    When every weight fits in 16 bits (narrow) the matrix is kept in w16,
+    which takes as much memory as a packed triangle of ints and halves
+    the traffic of the gain scans; otherwise it is kept in w32.
+*/
+struct Weights {
+    int n;
+    bool narrow;
+    vector<short> w16;
+    vector<int> w32;
+
+    Weights()
+    {
+        n = 0;
+        narrow = true;
+    }
+
+    /*
+        build fills the matrix with size vertices and the given edges.
+    */
+    void build(int size, const vector<pair<int, int> >& edges, const vector<int>& weights)
+    {
+        n = size;
+        narrow = true;
+        for (int i = 0; i < weights.size(); i++)
+            if (weights[i] < SHRT_MIN || weights[i] > SHRT_MAX)
+                narrow = false;
+        w16.clear();
+        w32.clear();
+        if (narrow)
+            fill(w16, edges, weights);
+        else
+            fill(w32, edges, weights);
+    }
+
+    /*
+        reset makes room for size vertices with every pair at weight -1,
+        in 16 bits when wide is false, so that the caller can fill the
+        matrix with set() instead of going through an edge list.
+    */
+    void reset(int size, bool wide)
+    {
+        n = size;
+        narrow = !wide;
+        if (narrow) {
+            vector<int>().swap(w32);
+            w16.assign((size_t)n * n, -1);
+        } else {
+            vector<short>().swap(w16);
+            w32.assign((size_t)n * n, -1);
+        }
+    }
+
+    void set(int i, int j, int w)
+    {
+        size_t a = (size_t)i * n + j, b = (size_t)j * n + i;
+        if (narrow)
+            w16[a] = w16[b] = w;
+        else
+            w32[a] = w32[b] = w;
+    }
+
+    int operator()(int i, int j) const
+    {
+        size_t k = (size_t)i * n + j;
+        return narrow ? w16[k] : w32[k];
+    }
+
+    const short* row16(int i) const
+    {
+        return &w16[(size_t)i * n];
+    }
+
+    const int* row32(int i) const
+    {
+        return &w32[(size_t)i * n];
+    }
+
+private:
+    template <class T>
+    void fill(vector<T>& w, const vector<pair<int, int> >& edges, const vector<int>& weights)
+    {
+        w.assign((size_t)n * n, -1);
+        for (int i = 0; i < edges.size(); i++) {
+            int u = edges[i].first, v = edges[i].second;
+            w[(size_t)u * n + v] = w[(size_t)v * n + u] = weights[i];
+        }
+    }
+};
+
+/*
+    Gain kernels. A face (a, b, c) is scored against every vertex at once:
+    the gain of v is ra[v] + rb[v] + rc[v] + penalty[v], where ra, rb and
+    rc are the matrix rows of the corners and penalty is 0 for the
+    vertices left to insert and USED for the others. Rows are contiguous,
+    so the scan is plain vector loads, without gathers.
+
+    The vertices are scanned in blocks: the maximum of each block is found
+    with SIMD, and only the first block reaching the overall maximum is
+    scanned again for its smallest vertex, which keeps the tie-break of
+    the scalar scan.
+*/
+const int USED = INT_MIN / 2;
+const int GAIN_BLOCK = 256;
+
+template <class T>
+int blockMaxScalar(const T* ra, const T* rb, const T* rc, const int* penalty, int n)
+{
+    int m = INT_MIN;
+    for (int v = 0; v < n; v++)
+        m = max(m, ra[v] + rb[v] + rc[v] + penalty[v]);
+    return m;
+}
+
+#ifdef TMFG_X86
+__attribute__((target("avx2"))) inline __m256i load8(const short* p)
+{
+    return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p));
+}
+
+__attribute__((target("avx2"))) inline __m256i load8(const int* p)
+{
+    return _mm256_loadu_si256((const __m256i*)p);
+}
+
+template <class T>
+__attribute__((target("avx2")))
+int blockMaxAvx2(const T* ra, const T* rb, const T* rc, const int* penalty, int n)
+{
+    __m256i m = _mm256_set1_epi32(INT_MIN);
+    int v = 0;
+    for (; v + 8 <= n; v += 8) {
+        __m256i g = _mm256_add_epi32(_mm256_add_epi32(load8(ra + v), load8(rb + v)),
+            _mm256_add_epi32(load8(rc + v), load8(penalty + v)));
+        m = _mm256_max_epi32(m, g);
+    }
+    // fold the 8 lanes into one
+    __m128i h = _mm_max_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+    h = _mm_max_epi32(h, _mm_shuffle_epi32(h, 0x4E));
+    h = _mm_max_epi32(h, _mm_shuffle_epi32(h, 0xB1));
+    int r = _mm_cvtsi128_si32(h);
+    for (; v < n; v++)
+        r = max(r, ra[v] + rb[v] + rc[v] + penalty[v]);
+    return r;
+}
+
+const bool hasAvx2 = __builtin_cpu_supports("avx2");
+#else
+const bool hasAvx2 = false;
+#endif
+
+/*
+    maxGainRows returns the largest gain and stores in vertex the smallest
+    vertex reaching it, or -1 if every vertex is used.
+*/
+template <class T>
+int maxGainRows(const T* ra, const T* rb, const T* rc, const int* penalty, int n, int& vertex)
+{
+    int best = INT_MIN, block = 0;
+    for (int s = 0; s < n; s += GAIN_BLOCK) {
+        int len = min(GAIN_BLOCK, n - s), m;
+#ifdef TMFG_X86
+        if (hasAvx2)
+            m = blockMaxAvx2(ra + s, rb + s, rc + s, penalty + s, len);
+        else
+#endif
+            m = blockMaxScalar(ra + s, rb + s, rc + s, penalty + s, len);
+        if (m > best) {
+            best = m;
+            block = s;
+        }
+    }
+    vertex = -1;
+    if (best <= USED / 2)
+        return 0;
+    for (int v = block; vertex == -1; v++)
+        if (ra[v] + rb[v] + rc[v] + penalty[v] == best)
+            vertex = v;
+    return best;
+}
+
+/*
+    topSeeds returns the starting 4-cliques made of the k vertices with
+    the largest total weight, every 4-combination of them, in
+    lexicographic order of their ranks. The heaviest vertex comes first
+    and ties go to the smaller vertex.
+*/
+inline vector<array<int, 4> > topSeeds(const Weights& graph, int k)
+{
+    int n = graph.n;
+    vector<pair<long long, int> > total(n);
+    for (int i = 0; i < n; i++)
+        total[i] = make_pair(0LL, i);
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++) {
+            int w = graph(i, j);
+            total[i].first -= w;
+            total[j].first -= w;
+        }
+    k = min(k, n);
+    partial_sort(total.begin(), total.begin() + k, total.end());
+
+    vector<array<int, 4> > seeds;
+    for (int a = 0; a < k; a++)
+        for (int b = a + 1; b < k; b++)
+            for (int c = b + 1; c < k; c++)
+                for (int d = c + 1; d < k; d++) {
+                    array<int, 4> seed = {{total[a].second, total[b].second,
+                        total[c].second, total[d].second}};
+                    seeds.push_back(seed);
+                }
+    return seeds;
+}
+
+class TmfgBuilder {
+public:
+    TmfgBuilder(const Weights& w)
+        : graph(w)
+    {
+        faces = 0;
+    }
+
+    /*
+        build grows the TMFG from the tetrahedron seed, always inserting
+        the remaining vertex with the largest gain into its best face,
+        and returns the total weight of the result.
+    */
+    int build(const int* seed)
+    {
+        clearGraph();
+        generateClique(seed);
+        generateList(seed);
+        return tmfg(generateTriangularFaceList(seed));
+    }
+
+    /*
+        edges returns the edges of the last graph built.
+    */
+    vector<pair<int, int> >& edges()
+    {
+        return T;
+    }
+
+private:
+    /*
+        Best is the best insertion into a face: the remaining vertex with
+        the largest gain, and the smallest such vertex on ties. version is
+        the one the face had when it was computed; operationT2 bumps it.
+
+        The heap pops the largest gain first, then the smallest vertex,
+        then the smallest face, which is the order a full scan of every
+        vertex against every face would pick in.
+    */
+    struct Best {
+        int gain, vertex, face, version;
+
+        bool operator<(const Best& o) const
+        {
+            if (gain != o.gain)
+                return gain < o.gain;
+            if (vertex != o.vertex)
+                return vertex > o.vertex;
+            return face > o.face;
+        }
+    };
+
+    /*
+        faces   ---> Quantity of triangular faces
+        left    ---> Number of vertices which are not on the planar graph yet
+        T       ---> Edges of the output graph, 3 * SIZE - 6 of them
+        F       ---> List containing triangular faces
+        version ---> Number of times each face slot was rewritten
+        penalty ---> USED for the vertices already on the planar graph,
+                     0 for the others
+    */
+    const Weights& graph;
+    int faces, left;
+    vector<pair<int, int> > T;
+    vector<array<int, 3> > F;
+    vector<int> version, penalty;
+
+    void clearGraph()
+    {
+        int n = graph.n;
+        faces = 0;
+        T.clear();
+        T.reserve(max(3 * n - 6, 6));
+        array<int, 3> none = {{-1, -1, -1}};
+        F.assign(max(2 * n - 4, 4), none);
+        version.assign(F.size(), 0);
+    }
+
+    void generateClique(const int* seed)
+    {
+        for (int i = 0; i < 4; i++)
+            for (int j = i + 1; j < 4; j++)
+                T.push_back(make_pair(seed[i], seed[j]));
+    }
+
+    // marks the vertices which are not on the planar graph
+    void generateList(const int* seed)
+    {
+        penalty.assign(graph.n, 0);
+        for (int i = 0; i < 4; i++)
+            penalty[seed[i]] = USED;
+        left = graph.n - 4;
+    }
+
+    // returns the weight of the planar graph so far
+    int generateTriangularFaceList(const int* seed)
+    {
+        int va = seed[0], vb = seed[1], vc = seed[2], vd = seed[3];
+
+        // generate first triangle of the output graph
+        F[faces][0] = va, F[faces][1] = vb, F[faces++][2] = vc;
+        int resp = graph(va, vb) + graph(va, vc) + graph(vb, vc);
+
+        // generate the next 3 possible faces
+        F[faces][0] = va, F[faces][1] = vb, F[faces++][2] = vd;
+        F[faces][0] = va, F[faces][1] = vc, F[faces++][2] = vd;
+        F[faces][0] = vb, F[faces][1] = vc, F[faces++][2] = vd;
+        resp += graph(va, vd) + graph(vb, vd) + graph(vc, vd);
+
+        return resp;
+    }
+
+    // inserts a new vertex, 3 new triangular faces
+    // and removes face 'f' from the list
+    int operationT2(int new_vertex, int f)
+    {
+        // remove the chosen face and insert a new one
+        int va = F[f][0], vb = F[f][1], vc = F[f][2];
+        F[f][0] = new_vertex, F[f][1] = va, F[f][2] = vb;
+        // and insert the other two possible faces
+        F[faces][0] = new_vertex, F[faces][1] = va, F[faces++][2] = vc;
+        F[faces][0] = new_vertex, F[faces][1] = vb, F[faces++][2] = vc;
+
+        T.push_back(make_pair(new_vertex, va));
+        T.push_back(make_pair(new_vertex, vb));
+        T.push_back(make_pair(new_vertex, vc));
+
+        return graph(va, new_vertex) + graph(vb, new_vertex) + graph(vc, new_vertex);
+    }
+
+    // returns the remaining vertex with the maximum gain inserting within face 'f'
+    Best maxGain(int f)
+    {
+        int va = F[f][0], vb = F[f][1], vc = F[f][2];
+        Best best = {0, -1, f, version[f]};
+        if (graph.narrow)
+            best.gain = maxGainRows(graph.row16(va), graph.row16(vb), graph.row16(vc),
+                &penalty[0], graph.n, best.vertex);
+        else
+            best.gain = maxGainRows(graph.row32(va), graph.row32(vb), graph.row32(vc),
+                &penalty[0], graph.n, best.vertex);
+        return best;
+    }
+
+    /*
+        tmfg inserts the remaining vertices one at a time, always the one
+        with the maximum gain over all faces. A max-heap keeps the best
+        vertex of every face: only the three faces made by operationT2 are
+        scored again, and an entry whose vertex was consumed meanwhile is
+        rescored when it reaches the top, since its gain can only have
+        dropped.
+    */
+    int tmfg(int tmpMax)
+    {
+        int maxValue = tmpMax;
+        priority_queue<Best> heap;
+        for (int f = 0; f < faces; f++)
+            heap.push(maxGain(f));
+
+        while (left > 0) {
+            Best best = heap.top();
+            heap.pop();
+            if (best.version != version[best.face])
+                continue;
+            if (penalty[best.vertex]) {
+                heap.push(maxGain(best.face));
+                continue;
+            }
+
+            penalty[best.vertex] = USED;
+            left--;
+            maxValue += operationT2(best.vertex, best.face);
+            version[best.face]++;
+            if (left == 0)
+                break;
+            heap.push(maxGain(best.face));
+            heap.push(maxGain(faces - 2));
+            heap.push(maxGain(faces - 1));
+        }
+        return maxValue;
+    }
+};
+
+/*
+    searchSeeds builds a TMFG of graph from every seed on the given number
+    of threads, each one with its own builder, and leaves the edges of the
+    heaviest in R. Ties go to the later seed. Returns the weight of R.
+*/
+inline int searchSeeds(const Weights& graph, const vector<array<int, 4> >& seeds, int threads,
+    vector<pair<int, int> >& R)
+{
+    // best -> weight of the best graph so far and its seed, packed so
+    //         that one atomic compare orders both
+    atomic<long long> best(LLONG_MIN);
+    atomic<int> next(0);
+    vector<vector<pair<int, int> > > found(threads);
+    vector<long long> mine(threads, LLONG_MIN);
+
+    ThreadPool pool(threads);
+    pool.run([&](int t) {
+        TmfgBuilder builder(graph);
+        for (int i = next++; i < seeds.size(); i = next++) {
+            long long key = (long long)builder.build(&seeds[i][0]) * (1LL << 32) + i;
+            long long seen = best;
+            while (key > seen && !best.compare_exchange_weak(seen, key))
+                ;
+            // a worse graph is dropped at once, without copying its edges
+            if (key > seen) {
+                mine[t] = key;
+                found[t].swap(builder.edges());
+            }
+        }
+    });
+
+    for (int t = 0; t < threads; t++)
+        if (mine[t] == best)
+            R.swap(found[t]);
+    return (int)((best - (best & 0xFFFFFFFFLL)) / (1LL << 32));
+}
+
+#endif
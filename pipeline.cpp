@@ -0,0 +1,207 @@
+/*
+    The generator -> TMFG -> planarity test pipeline in a single process.
+    Every graph goes through three stages, handed from one to the next by
+    pointer:
+
+        source  -> generates a random complete graph, or reads the next
+                   graph of stdin in any format GraphReader accepts
+        builder -> builds the TMFG of its weights (includes/tmfg.hpp)
+        checker -> tests that the TMFG is maximal planar
+                   (includes/planarity.hpp)
+
+    Each stage runs on its own thread, so the TMFG of graph k + 1 is built
+    while graph k is tested and graph k + 2 is read. Channels of one item
+    keep at most a few graphs in memory at a time.
+*/
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#define pb push_back
+#define mp make_pair
+
+using namespace std;
+
+#include "includes/helpers.hpp"
+#include "includes/graph_io.hpp"
+#include "includes/mmap_reader.hpp"
+#include "includes/planarity.hpp"
+#include "includes/tmfg.hpp"
+
+/*
+    Job is one graph on its way through the pipeline.
+
+    weights -> the input, released once the TMFG is built
+    V       -> number of vertices
+    edges   -> edges of the TMFG
+    total   -> weight of the TMFG
+*/
+struct Job {
+    int index, V, total;
+    Weights weights;
+    vector<pair<int, int> > edges;
+};
+
+/*
+    vertices -> vertices of the generated graphs, 0 to read stdin instead
+    graphs   -> number of graphs to generate
+    seed     -> seed of the first generated graph, the others follow it
+    top      -> vertices whose 4-cliques seed the TMFG, see topSeeds
+    threads  -> threads of the seed search
+*/
+int vertices = 0, graphs = 1, top = 0, threads = 1;
+unsigned seed;
+InputFormat format;
+GraphReader reader;
+
+/*
+    produce returns the graph with the given index, or NULL when there
+    are no more graphs.
+*/
+Job* produce(int index)
+{
+    Job* job;
+    if (vertices > 0) {
+        if (index >= graphs)
+            return NULL;
+        job = new Job();
+        // weights in [0, 200), the range of graph-generator
+        mt19937 rng(seed + index);
+        job->weights.reset(vertices, false);
+        for (int i = 0; i < vertices; i++)
+            for (int j = i + 1; j < vertices; j++)
+                job->weights.set(i, j, rng() % 200);
+    } else {
+        int V;
+        job = new Job();
+        if (!reader.nextMatrix(format, V, job->weights)) {
+            delete job;
+            return NULL;
+        }
+    }
+    job->index = index;
+    job->V = job->weights.n;
+    job->total = 0;
+    return job;
+}
+
+/*
+    buildTmfg builds the TMFG of the job's weights. Graphs with fewer
+    than 4 vertices have none and are left without edges.
+*/
+void buildTmfg(Job* job)
+{
+    if (job->V >= 4) {
+        vector<array<int, 4> > seeds;
+        if (top >= 4)
+            seeds = topSeeds(job->weights, top);
+        else {
+            array<int, 4> first = {{0, 1, 2, 3}};
+            seeds.pb(first);
+        }
+        int t = max(1, min(threads, (int)seeds.size()));
+        job->total = searchSeeds(job->weights, seeds, t, job->edges);
+    }
+    job->weights = Weights();
+}
+
+/*
+    check tests the job's TMFG and prints its line. Returns whether it
+    is maximal planar.
+*/
+bool check(Job* job, PlanarityTester& tester, Graph& graph)
+{
+    graph.build(job->V, job->edges);
+    bool ans = tester.isMaximalPlanar(graph);
+    printf("%d %d %s\n", job->index, job->total, ans ? "YES" : "NO");
+    return ans;
+}
+
+/*
+    Usage: pipeline [-g n [-c count] [-s seed]] [-d | -e] [-k top]
+                    [-p [threads]] [--serial]
+
+    -g generates count (1 by default) complete graphs on n vertices with
+    random weights, the first one from seed (the time by default) and the
+    next ones from seed + 1, seed + 2, ... Without -g the graphs of stdin
+    are read one after another, as dense matrices, edge lists (-d and -e
+    force one) or binary graphs.
+    -k and -p pick the TMFG seeds and the threads searching them, as for
+    tmfg.
+    --serial runs the stages one after another on a single thread.
+
+    Prints "index weight YES|NO" for every graph, and exits with 1 if
+    some TMFG was not maximal planar.
+*/
+int main(int argc, char** argv)
+{
+    format = parseFormat(argc, argv);
+    seed = time(NULL);
+    bool serial = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool value = (i + 1 < argc && isdigit(argv[i + 1][0]));
+        if (arg == "-g" && value)
+            vertices = atoi(argv[++i]);
+        else if (arg == "-c" && value)
+            graphs = atoi(argv[++i]);
+        else if (arg == "-s" && value)
+            seed = strtoul(argv[++i], NULL, 10);
+        else if (arg == "-k" && value)
+            top = atoi(argv[++i]);
+        else if (arg == "-p" || arg == "--parallel") {
+            threads = thread::hardware_concurrency();
+            if (value)
+                threads = atoi(argv[++i]);
+        } else if (arg == "--serial")
+            serial = true;
+    }
+    if (vertices <= 0)
+        reader.open(0);
+
+    PlanarityTester tester;
+    Graph graph;
+    bool good = true;
+
+    if (serial) {
+        Job* job;
+        for (int k = 0; (job = produce(k)); k++) {
+            buildTmfg(job);
+            good = check(job, tester, graph) && good;
+            delete job;
+        }
+        return good ? 0 : 1;
+    }
+
+    // loaded -> graphs waiting for their TMFG, built -> waiting for the test
+    Channel<Job*> loaded(1), built(1);
+    thread source([&]() {
+        Job* job;
+        for (int k = 0; (job = produce(k)); k++)
+            loaded.push(job);
+        loaded.close();
+    });
+    thread builder([&]() {
+        Job* job;
+        while (loaded.pop(job)) {
+            buildTmfg(job);
+            built.push(job);
+        }
+        built.close();
+    });
+
+    Job* job;
+    while (built.pop(job)) {
+        good = check(job, tester, graph) && good;
+        delete job;
+    }
+    source.join();
+    builder.join();
+    return good ? 0 : 1;
+}
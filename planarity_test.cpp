@@ -1,6 +1,10 @@
 /*
     A fast implementation of Nagamochi et al (2004) planarity test algorithm.
     The algorithm tests ONLY whether a graph is maximal planar or not.
+    The test itself lives in includes/planarity.hpp.
+
+    With --general, graphs are tested for planarity instead, by the
+    left-right test of includes/lr_planarity.hpp.
 */
 
 #include <iomanip>
@@ -9,288 +13,365 @@
 #include <set>
 #include <vector>
 #include <algorithm>
+#include <cstring>
 #define pb push_back
 #define mp make_pair
-#define MAX 5010
 
 using namespace std;
 
 #include "includes/helpers.hpp"
+#include "includes/dynamic_planarity.hpp"
+#include "includes/graph_io.hpp"
+#include "includes/mmap_reader.hpp"
+#include "includes/lr_planarity.hpp"
+#include "includes/planarity.hpp"
+#include "includes/prefilter.hpp"
+#include "includes/stats.hpp"
+
+Graph graph;
+vector<pair<int, int> > edges;
+vector<int> weights;
+// witnessed -> a NO answer is followed by its witness
+// filtered  -> text graphs go through the prefilter before being built
+// general   -> graphs are tested for planarity, not maximal planarity
+// augmented -> a general YES answer is followed by its augmentation
+bool witnessed = false, filtered = true, general = false, augmented = false;
+Prefilter filter;
+LrPlanarity lr;
+vector<pair<int, int> > augmentation;
 
 /*
-    V -> number of vertices
-    E -> number of edges
+    load reads the next graph from reader into graph. A graph rejected
+    by the prefilter is not built: passed is set to false and witness
+    says why.
 */
-int V, E;
-
-vector<int> graph[MAX];
-int vertex_map[MAX];
+bool load(GraphReader& reader, InputFormat format, bool& passed, Witness& witness)
+{
+    passed = true;
+    // binary graphs are used where they lie, nothing to build
+    if (reader.binary()) {
+        const int* w;
+        return reader.nextView(graph, w);
+    }
+    int V;
+    if (!reader.next(format, V, edges, weights))
+        return false;
+    if (filtered && !general && !(passed = filter.check(V, edges, witness)))
+        return true;
+    graph.build(V, edges);
+    return true;
+}
 
 /*
-    getVertex checks if the graph has a vertex with degree <= 5 and
-    returns the first one found. Otherwise, returns -1.
+    printEmbedding writes the embedding of a YES instance: a line
+    "embedding V F", then the clockwise neighbours of every vertex, one
+    line per vertex, and then the F faces, one triangle per line.
 */
-int getVertex()
+void printEmbedding(const Embedding& embedding)
 {
-    for (int v = 0; v < V; v++)
-        if (graph[v].size() <= 5)
-            return v;
-    return -1;
+    printf("embedding %d %d\n", embedding.V, embedding.faceCount());
+    for (int v = 0; v < embedding.V; v++) {
+        const int* around = embedding.around(v);
+        for (int i = 0; i < embedding.degree(v); i++)
+            printf(i ? " %d" : "%d", around[i]);
+        putchar('\n');
+    }
+    for (int f = 0; f < embedding.faceCount(); f++) {
+        const int* face = embedding.face(f);
+        printf("%d %d %d\n", face[0], face[1], face[2]);
+    }
 }
 
 /*
-    isTriangle checks if three vertices form a triangle.
+    printAugmentation writes the edges that make a planar graph maximal
+    planar: a line "augmentation k YES|NO", with the answer of the
+    maximal planarity test for the graph with them, and then the k
+    edges, one "u v" per line. The tester only takes graphs of 4 or more
+    vertices; a smaller one is maximal planar when it is complete.
 */
-bool isTriangle(int v1, int v2, int vn)
+void printAugmentation(PlanarityTester& tester)
 {
-    int count = 0;
-    for (int i = 0; i < graph[v1].size(); i++)
-        if (graph[v1][i] == v2 || graph[v1][i] == vn)
-            count++;
-
-    for (int i = 0; i < graph[v2].size(); i++)
-        if (graph[v2][i] == v1 || graph[v2][i] == vn)
-            count++;
-
-    return count == 4;
+    vector<pair<int, int> > all(augmentation);
+    for (int u = 0; u < graph.V; u++)
+        for (int i = graph.offset[u]; i < graph.offset[u + 1]; i++)
+            if (graph.adj[i] > u)
+                all.pb(mp(u, graph.adj[i]));
+    bool ans;
+    if (graph.V < 4)
+        ans = all.size() == graph.V * (graph.V - 1) / 2;
+    else {
+        Graph full;
+        full.build(graph.V, all);
+        ans = tester.isMaximalPlanar(full);
+    }
+    printf("augmentation %d %s\n", (int)augmentation.size(), ans ? "YES" : "NO");
+    for (int i = 0; i < augmentation.size(); i++)
+        printf("%d %d\n", augmentation[i].first, augmentation[i].second);
 }
 
 /*
-    order returns a canonical order of V(G) of three given vertices.
+    printWitness writes why a NO instance was rejected as a line
+    "witness reason step vertex a b c n_1 ... n_k", with the candidate
+    triangle (a, b, c) and the neighbours of vertex, -1 for what the
+    reason does not tell (see includes/planarity.hpp).
 */
-vector<int> order(int v1, int v2, int vn)
+void printWitness(const Witness& witness)
 {
-    // vector<int> graph_[MAX];
-    vector<int> VC, vi(V);
-    // vi -> vector with the output order of vertices
-    vi[0] = v1;
-    vi[1] = v2;
-    VC.pb(v1);
-    VC.pb(v2);
-    VC.pb(vn);
-
-    // x -> number of elements in VC
-    int x = VC.size(), pos = V - 1;
-
-    // set with remaining and removed vertices
-    set<int> vertices, R;
-    // insert all vertices but v1 and v2
-    for (int i = 0; i < V; i++)
-        if (v1 != i && v2 != i)
-            vertices.insert(i);
-
-    int v;
-    while (!vertices.empty()) {
-        // note: set_intersection only works if both intersecting sets are sorted
-        sort(VC.begin(), VC.end());
-        // vectors used for intersection and union operations
-        vector<int> a(V), b(V);
-        vector<int>::iterator vit;
-        int sz = -1;
-
-        // choose a vertex v belonging to VC which is neither v1 nor v2
-        // and which its neighbours' intersection with VC has size == 2.
-        for (int i = 0; i < x; i++) {
-            if (VC[i] == v1 || VC[i] == v2)
-                continue;
-            v = VC[i];
-            // always resize the sink after an intersection
-            vit = set_intersection(graph[v].begin(), graph[v].end(), VC.begin(), VC.end(), a.begin());
-            sz = (int)(vit - a.begin());
-            a.resize(sz);
-
-            vector<int> aux;
-            for (int k = 0; k < sz; k++) {
-                // check if a removed vertex is within the intersection.
-                // if it is, do not put it
-                if (!R.count(a[k])) {
-                    aux.pb(a[k]);
-                }
-            }
-            sz = aux.size();
-            if (sz != 2)
-                continue;
-            break;
-        }
-        // if such vertex does not exist, halt.
-        if (sz != 2)
-            return vector<int>();
-
-        // otherwise, remove this vertex from VC
-        for (int i = 0; i < x; i++) {
-            if (VC[i] == v) {
-                swap(VC[i], VC[x - 1]);
-                VC.pop_back();
-                break;
-            }
-        }
-
-        // and join VC with the chosen vertex's neighbours.
-        sort(VC.begin(), VC.end());
-        vit = set_union(VC.begin(), VC.end(), graph[v].begin(), graph[v].end(), b.begin());
-        x = (int)(vit - b.begin());
-        b.resize(x);
-
-        vector<int> aux;
-        for (int k = 0; k < x; k++) {
-            // check if a removed vertex is within the union.
-            // if it is, do not put it
-            if (!R.count(b[k])) {
-                aux.pb(b[k]);
-            }
-        }
-        x = aux.size();
-        VC = aux;
-
-        vertices.erase(v);
-        R.insert(v);
-
-        // add the chosen vertex to the answer
-        vi[pos] = v;
-        pos--;
-    }
-
-    return vi;
+    printf("witness %s %d %d %d %d %d", reasonNames[witness.reason], witness.step,
+        witness.vertex, witness.triangle[0], witness.triangle[1], witness.triangle[2]);
+    for (int i = 0; i < witness.neighbours.size(); i++)
+        printf(" %d", witness.neighbours[i]);
+    putchar('\n');
 }
 
 /*
-    areConsecutive checks if a set of vertices appear
-    consecutively into another sequence.
+    answer tests graph, unless the prefilter has already turned it down
+    (passed is false): for planarity with --general, and otherwise for
+    maximal planarity, filling embedding and witness when they are
+    given.
 */
-bool areConsecutive(vector<int>& tmp, vector<int>& VC)
+bool answer(PlanarityTester& tester, bool passed, Embedding* embedding, Witness* witness)
 {
-    int sz = VC.size(), t = tmp.size(), k = sz;
-    vector<int> aux = VC;
-    if (t > k)
-        return false;
-    // where is the lower bound occurence of an element of the intersection?
-    for (int i = 0; i < t; i++) {
-        k = min(k, vertex_map[tmp[i]]);
-    }
+    if (general)
+        return lr.isPlanar(graph, augmented ? &augmentation : NULL);
+    return passed && tester.isMaximalPlanar(graph, embedding, witness);
+}
 
-    if (k + t > sz)
-        return false;
-    sort(aux.begin() + k, aux.begin() + k + t);
+/*
+    printAnswer prints the YES/NO line of the graph just tested, and
+    after it what the flags ask for.
+*/
+void printAnswer(PlanarityTester& tester, bool ans, const Embedding* embedding, const Witness& witness)
+{
+    puts(ans ? "YES" : "NO");
+    if (ans && general && augmented)
+        printAugmentation(tester);
+    if (ans && embedding)
+        printEmbedding(*embedding);
+    if (!ans && witnessed && !general)
+        printWitness(witness);
+}
 
-    for (int i = 0; i < t; i++, k++) {
-        if (tmp[i] != aux[k])
-            return false;
+/*
+    testAll prints one YES/NO line for every graph left in reader,
+    prefixed by name when it is given.
+*/
+void testAll(PlanarityTester& tester, GraphReader& reader, InputFormat format, const string& name)
+{
+    Witness witness;
+    bool passed;
+    while (load(reader, format, passed, witness)) {
+        if (!name.empty())
+            printf("%s ", name.c_str());
+        bool ans = answer(tester, passed, NULL, witnessed ? &witness : NULL);
+        printAnswer(tester, ans, NULL, witness);
     }
-    return true;
 }
 
 /*
-    embed checks if the graph has a planar embedding.
+    batch tests every graph of stdin, or of every file in dir.
 */
-vector<int> embed(vector<int>& pi)
+int batch(PlanarityTester& tester, InputFormat format, const char* dir)
 {
-    vector<int> VC, sorted_pi(pi.begin(), pi.end());
-    VC.pb(pi[0]);
-    VC.pb(pi[2]);
-    VC.pb(pi[1]);
-
-    for (int i = 3; i < V; i++) {
-        vector<int> tmp(2 * V);
-        vector<int>::iterator vit;
-        // sublist {u_p, u_p+1, ..., u_p+n} = {v1, ..., v_i-1} inter NG(vi)
-        sort(sorted_pi.begin(), sorted_pi.begin() + i);
-
-        vit = set_intersection(sorted_pi.begin(), sorted_pi.begin() + i, graph[pi[i]].begin(), graph[pi[i]].end(), tmp.begin());
-        int sz = (int)(vit - tmp.begin());
-        tmp.resize(sz);
-
-        for (int j = 0; j < VC.size(); j++)
-            vertex_map[VC[j]] = j;
+    if (!dir) {
+        GraphReader reader;
+        reader.open(0);
+        testAll(tester, reader, format, "");
+        return 0;
+    }
 
-        // where is the lower and higher bound occurences of the elements
-        // on the intersection?
-        int lb = VC.size(), hb = -1;
-        for (int i = 0; i < tmp.size(); i++) {
-            lb = min(lb, vertex_map[tmp[i]]);
-            hb = max(hb, vertex_map[tmp[i]]);
+    vector<string> files;
+    if (!listFiles(dir, files)) {
+        fprintf(stderr, "cannot read directory %s\n", dir);
+        return 1;
+    }
+    for (int i = 0; i < files.size(); i++) {
+        string path = string(dir) + "/" + files[i];
+        int fd = open(path.c_str(), O_RDONLY);
+        GraphReader reader;
+        if (fd == -1 || !reader.open(fd)) {
+            fprintf(stderr, "cannot map %s\n", path.c_str());
+            if (fd != -1)
+                ::close(fd);
+            continue;
         }
-
-        if (areConsecutive(tmp, VC)) {
-            vector<int> cons;
-            int k = 0;
-            while (k < lb)
-                cons.pb(VC[k++]);
-            cons.pb(VC[lb]);
-            cons.pb(pi[i]);
-            cons.pb(VC[hb]);
-            while (k <= hb)
-                k++;
-            while (k < VC.size())
-                cons.pb(VC[k++]);
-
-            VC = cons;
-        } else
-            return vector<int>();
+        ::close(fd);
+        testAll(tester, reader, format, files[i]);
     }
-    return VC;
+    return 0;
 }
 
 /*
-    Recognizes if a given graph is either maximal planar or not
+    replay tests the graph of stdin, then applies the updates listed in
+    the file at path batch by batch (see includes/dynamic_planarity.hpp),
+    printing a YES/NO line for the graph and after every batch. Each
+    line of the file is "flip u v", "insert u v", "delete u v", or
+    "check", which ends a batch, as does the end of the file; blank
+    lines are skipped. Refused updates are reported on stderr, and any
+    other line stops the replay with an error before its batch is
+    applied.
 */
-bool recognize()
+int replay(InputFormat format, const char* path, int threads)
 {
-    int v1 = getVertex(), v2, p = graph[v1].size();
-    if (E != (3 * V - 6) || v1 == -1)
-        return false;
-    v2 = graph[v1][p - 1];
-    for (int i = 0; i < p - 2; i++) {
-        int vn = graph[v1][i];
-        cout << "vn " << vn + 1 << "\n";
-        if (!isTriangle(v1, v2, vn))
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+    GraphReader reader;
+    reader.open(0);
+    bool passed;
+    Witness witness;
+    filtered = false;
+    if (!load(reader, format, passed, witness)) {
+        fclose(in);
+        return 1;
+    }
+    DynamicPlanarity dynamic(threads);
+    puts(dynamic.reset(graph) ? "YES" : "NO");
+
+    vector<Update> batch;
+    char line[256], op[16], extra;
+    for (int n = 1, k = 1;; n++) {
+        bool more = (fgets(line, sizeof(line), in) != NULL);
+        line[strcspn(line, "\n")] = 0;
+        Update up;
+        int fields = (more ? sscanf(line, "%15s %d %d %c", op, &up.u, &up.v, &extra) : 0);
+        // blank lines are skipped
+        if (more && fields <= 0)
             continue;
-
-        cout << v1 + 1 << " " << v2 + 1 << " " << vn + 1 << " form a triangle.\n\n";
-
-        vector<int> pi = order(v1, v2, vn);
-        if (!pi.size())
+        if (!more || (string(op) == "check" && sscanf(line, "%15s %c", op, &extra) == 1)) {
+            if (more || !batch.empty()) {
+                int refused;
+                bool ans = dynamic.apply(batch, &refused);
+                puts(ans ? "YES" : "NO");
+                if (refused)
+                    fprintf(stderr, "batch %d: %d updates refused\n", k, refused);
+                batch.clear();
+                k++;
+            }
+            if (!more)
+                break;
             continue;
-
-        cout << "Order" << "\n";
-        for (int k = 0; k < pi.size(); k++) {
-            cout << pi[k] + 1 << " ";
-            vertex_map[pi[k]] = k;
         }
-        cout << "\n";
-
-        vector<int> ans = embed(pi);
-        if (ans.size())
-            return true;
+        string word = op;
+        if (fields != 3 || (word != "flip" && word != "insert" && word != "delete")) {
+            fprintf(stderr, "%s:%d: malformed update \"%s\"\n", path, n, line);
+            fclose(in);
+            return 1;
+        }
+        up.kind = (word == "flip" ? UPDATE_FLIP : word == "insert" ? UPDATE_INSERT : UPDATE_DELETE);
+        batch.pb(up);
     }
-    return false;
+    fclose(in);
+    return 0;
 }
 
-int main()
+/*
+    Usage: planarity_test [-d | -e] [-p [threads]] [-b [dir]] [--stats]
+                          [--profile [--no-counters]] [--trace] [--embedding]
+                          [--witness] [--no-prefilter] [--general [--augment]]
+                          [--updates file]
+
+    -p (--parallel) tries the candidate triangles on several threads,
+    one per core unless a number is given.
+    -b (--batch) tests every graph of the input stream, or of every file
+    in dir, printing one line per graph.
+    --embedding prints the rotation system and the faces of a YES
+    instance after its answer (see printEmbedding).
+    --witness prints why a NO instance was rejected after its answer, in
+    batch mode too (see printWitness).
+    --no-prefilter builds and tests every graph, without rejecting the
+    hopeless ones first (see includes/prefilter.hpp).
+    --general tests whether each graph is planar, maximal or not, in
+    linear time (see includes/lr_planarity.hpp). Neither the prefilter,
+    nor --embedding and --witness apply to it; --augment instead prints
+    the edges making a planar graph maximal planar, along with the
+    maximal planarity test's answer for the result (see
+    printAugmentation).
+    --updates applies the batches of edge updates in file to the graph
+    of stdin, checking it again after each one (see replay).
+    --stats writes the time, allocations and peak memory of the read,
+    build and test phases to stderr (see includes/stats.hpp).
+    --profile and --trace write the time spent in each section of the
+    test, and the candidates and orders tried, to stderr as JSON
+    (see includes/instrument.hpp).
+*/
+int main(int argc, char** argv)
 {
     // ios::sync_with_stdio(false);
-    int vj;
-    clock_t start, stop;
-    start = clock();
-    read(V);
-
-    E = 0;
-    for (int i = 0; i < V - 1; i++) {
-        for (int j = i + 1; j < V; j++) {
-            read(vj);
-            if (vj == -1)
-                continue;
-            graph[i].pb(j);
-            graph[j].pb(i);
-            E++;
+    InputFormat format = parseFormat(argc, argv);
+    bool profiled = parseInstrument(argc, argv);
+    int threads = 1;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--witness")
+            witnessed = true;
+        else if (arg == "--no-prefilter")
+            filtered = false;
+        else if (arg == "--general")
+            general = true;
+        else if (arg == "--augment")
+            augmented = true;
+        if (arg != "-p" && arg != "--parallel")
+            continue;
+        threads = thread::hardware_concurrency();
+        if (i + 1 < argc && isdigit(argv[i + 1][0]))
+            threads = atoi(argv[i + 1]);
+    }
+    PlanarityTester tester(threads);
+
+    const char* dir = NULL;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--updates" && i + 1 < argc)
+            return replay(format, argv[i + 1], threads);
+        if (arg == "-b" || arg == "--batch") {
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                dir = argv[i + 1];
+            int status = batch(tester, format, dir);
+            if (profiled)
+                instrument.report(stderr);
+            return status;
         }
     }
 
-    for (int i = 0; i < V; i++)
-        sort(graph[i].begin(), graph[i].end());
-
-    puts(recognize() ? "YES" : "NO");
+    clock_t start, stop;
+    start = clock();
+    Stats stats;
+    stats.enabled = parseStats(argc, argv);
+
+    GraphReader reader;
+    reader.open(0);
+    int V;
+    const int* w;
+    bool binary = reader.binary();
+    if (binary ? !reader.nextView(graph, w) : !reader.next(format, V, edges, weights))
+        return 1;
+    stats.stop("read");
+    Witness witness;
+    bool passed = true;
+    if (!binary) {
+        passed = !filtered || general || filter.check(V, edges, witness);
+        stats.stop("filter");
+        if (passed)
+            graph.build(V, edges);
+    }
+    stats.stop("build");
+
+    bool embedded = false;
+    for (int i = 1; i < argc; i++)
+        if (string(argv[i]) == "--embedding")
+            embedded = true;
+    Embedding embedding;
+    bool ans = answer(tester, passed, embedded ? &embedding : NULL, witnessed ? &witness : NULL);
+    stats.stop("test");
+    printAnswer(tester, ans, embedded && !general ? &embedding : NULL, witness);
     stop = clock();
+    stats.report(ans);
+    if (profiled)
+        instrument.report(stderr);
 
     printElapsedTime(start, stop);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,62 @@
+#!/bin/sh
+#
+# Regression checks for the drivers. They are built into a temporary
+# directory and run on the fixtures next to this script; every check
+# prints "ok" or "FAIL" with what it got, and the script exits with 1
+# if any of them failed.
+#
+# Usage: tests/regress.sh
+#
+cd "$(dirname "$0")/.." || exit 1
+bin=$(mktemp -d)
+trap 'rm -rf "$bin"' EXIT
+CXX=${CXX:-g++}
+FLAGS="-O2 -std=c++11 -pthread"
+$CXX $FLAGS planarity_test.cpp -o "$bin/planarity_test" || exit 1
+$CXX $FLAGS graph-generator/tmfg.cpp -o "$bin/tmfg" || exit 1
+
+failed=0
+
+# check name expected actual
+check()
+{
+    if [ "$2" = "$3" ]; then
+        echo "ok   $1"
+    else
+        echo "FAIL $1: expected $(echo $2), got $(echo $3)"
+        failed=1
+    fi
+}
+
+# A flip that comes after an insert the embedding could not take must
+# embed the graph again rather than be refused: here it creates (0, 1),
+# which the next batch deletes.
+got=$("$bin/planarity_test" --updates tests/flip-after-insert.updates < tests/flip-after-insert.in 2>&1)
+check "flip after an unembedded insert" "YES
+YES
+NO" "$got"
+
+# tested input out -> what planarity_test --embedding says about the
+# TMFG of input written with --out out, without the timing line
+tested()
+{
+    "$bin/tmfg" --out "$2" < "$1" 2>/dev/null | "$bin/planarity_test" --embedding | grep -v '^Elapsed'
+}
+
+# The three output formats of tmfg must describe the same graph. The
+# embedding lists every edge, so equal output means equal edge sets.
+dense=$(tested inputs/100-vertices-input.in dense)
+check "tmfg --out dense is a maximal planar graph" YES "$(echo "$dense" | head -n 1)"
+check "tmfg --out edges round-trips like dense" "$dense" "$(tested inputs/100-vertices-input.in edges)"
+check "tmfg --out binary round-trips like dense" "$dense" "$(tested inputs/100-vertices-input.in binary)"
+
+# On a sparse edge list the TMFG also takes pairs missing from the
+# input, of weight -1, which the dense matrix cannot hold: tmfg must
+# refuse it rather than drop them.
+edges=$(tested tests/sparse-30.in edges)
+check "tmfg of a sparse edge list is a maximal planar graph" YES "$(echo "$edges" | head -n 1)"
+"$bin/tmfg" < tests/sparse-30.in > /dev/null 2>&1
+check "tmfg refuses dense output with edges of weight -1" 1 $?
+check "tmfg --out binary round-trips like edges" "$edges" "$(tested tests/sparse-30.in binary)"
+
+exit $failed